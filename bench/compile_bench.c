@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "arena.h"
+#include "docmark_compiler.h"
+#include "docmark_token.h"
+#include "identifier_array.h"
+
+#define BENCH_REPETITIONS 3
+#define BENCH_OUTPUT_PATH "/dev/null" // Written to, so that the whole compiler is measured without the disk
+
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Names a corpus after its file, without the directory or extension
+ */
+static void corpus_name(const char *path, char *name, size_t capacity) {
+	const char *start = strrchr(path, '/');
+	start = start ? start + 1 : path;
+	const char *end = strrchr(start, '.');
+	size_t length = end ? (size_t)(end - start) : strlen(start);
+	if (length >= capacity) {
+		length = capacity - 1;
+	}
+	memcpy(name, start, length);
+	name[length] = '\0';
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <corpus>...\n", argv[0]);
+		return 1;
+	}
+
+	IdentifierArray *heading_identifier_array = create_identifier_array();
+	IdentifierArray *other_identifier_array = create_identifier_array();
+	Arena *arena = create_arena(0, 0);
+	TokenTree *tree = create_token_tree();
+
+	int status = 0;
+	size_t total_bytes = 0;
+	double total_seconds = 0;
+	printf("  %-14s %12s %10s %10s\n", "mix", "bytes", "MB/s", "ns/byte");
+	for (int i = 1; i < argc; ++i) {
+		struct stat input_status;
+		if (stat(argv[i], &input_status) != 0) {
+			fprintf(stderr, "Error opening input file: %s\n", argv[i]);
+			status = 1;
+			continue;
+		}
+		size_t length = input_status.st_size;
+
+		// The best repetition is reported, as the others only add noise from the rest of the system
+		double best = 0;
+		for (int repetition = 0; repetition < BENCH_REPETITIONS; ++repetition) {
+			struct timespec start, end;
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			int result = compile_file(
+				argv[i],
+				BENCH_OUTPUT_PATH,
+				heading_identifier_array,
+				other_identifier_array,
+				arena,
+				tree,
+				NULL
+			);
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			if (result != 0) {
+				status = 1;
+			}
+
+			double seconds = elapsed_seconds(&start, &end);
+			if (repetition == 0 || seconds < best) {
+				best = seconds;
+			}
+		}
+
+		char name[64];
+		corpus_name(argv[i], name, sizeof(name));
+		printf("  %-14s %12zu %10.1f %10.2f\n", name, length, length / best / 1e6, best * 1e9 / length);
+		total_bytes += length;
+		total_seconds += best;
+	}
+	if (total_seconds > 0) {
+		printf("  %-14s %12zu %10.1f %10.2f\n", "total", total_bytes, total_bytes / total_seconds / 1e6, total_seconds * 1e9 / total_bytes);
+	}
+
+	free_token_tree(tree);
+	free_arena(arena);
+	free_identifier_array(heading_identifier_array);
+	free_identifier_array(other_identifier_array);
+	return status;
+}
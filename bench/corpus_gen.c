@@ -0,0 +1,414 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LONG_LINE_LENGTH (64 * 1024) // Length of the single-line paragraphs in the adversarial mix
+#define DEEP_NESTING_LEVELS 32 // Levels of the deeply nested lists and quotes in the adversarial mix
+#define MAX_LIST_DEPTH 4 // Levels of the nested lists in the realistic mixes
+
+/**
+ * @brief The kinds of block written to a corpus, chosen at random in proportion to a mix's weights
+ */
+typedef enum BlockKind {
+	PROSE_BLOCK,
+	EMPHASIS_BLOCK,
+	HEADING_BLOCK,
+	LIST_BLOCK,
+	QUOTE_BLOCK,
+	CODE_BLOCK,
+	COLUMN_BLOCK,
+	DESCRIPTION_BLOCK,
+	RULE_BLOCK,
+
+	// Adversarial blocks, which stress the worst cases of the lexer and parser
+	UNCLOSED_BLOCK,
+	LONG_LINE_BLOCK,
+	DEEP_LIST_BLOCK,
+	DEEP_QUOTE_BLOCK,
+	REPEATED_HEADING_BLOCK,
+
+	BLOCK_KIND_COUNT,
+} BlockKind;
+
+typedef struct Mix {
+	const char *name;
+	unsigned int weights[BLOCK_KIND_COUNT];
+} Mix;
+
+static const Mix mixes[] = {
+	{"prose", {[PROSE_BLOCK] = 8, [HEADING_BLOCK] = 1}},
+	{"emphasis", {[EMPHASIS_BLOCK] = 8, [HEADING_BLOCK] = 1}},
+	{"headings", {[HEADING_BLOCK] = 4, [PROSE_BLOCK] = 1}},
+	{"lists", {[LIST_BLOCK] = 8, [PROSE_BLOCK] = 1}},
+	{"quotes", {[QUOTE_BLOCK] = 8, [PROSE_BLOCK] = 1}},
+	{"code", {[CODE_BLOCK] = 8, [PROSE_BLOCK] = 1}},
+	{"columns", {[COLUMN_BLOCK] = 8, [PROSE_BLOCK] = 1}},
+	{"descriptions", {[DESCRIPTION_BLOCK] = 8, [PROSE_BLOCK] = 1}},
+	{"mixed", {
+		[PROSE_BLOCK] = 12,
+		[EMPHASIS_BLOCK] = 3,
+		[HEADING_BLOCK] = 4,
+		[LIST_BLOCK] = 4,
+		[QUOTE_BLOCK] = 2,
+		[CODE_BLOCK] = 2,
+		[COLUMN_BLOCK] = 1,
+		[DESCRIPTION_BLOCK] = 1,
+		[RULE_BLOCK] = 1,
+	}},
+	{"adversarial", {
+		[UNCLOSED_BLOCK] = 4,
+		[LONG_LINE_BLOCK] = 1,
+		[DEEP_LIST_BLOCK] = 1,
+		[DEEP_QUOTE_BLOCK] = 2,
+		[REPEATED_HEADING_BLOCK] = 4,
+		[EMPHASIS_BLOCK] = 2,
+	}},
+};
+
+static const char *const words[] = {
+	"the", "a", "of", "and", "to", "in", "is", "that", "for", "it", "as", "with", "on", "by", "this", "be",
+	"document", "compiler", "heading", "paragraph", "section", "note", "table", "figure", "reference", "value",
+	"function", "variable", "example", "output", "input", "markup", "parser", "token", "stream", "buffer",
+	"quickly", "rarely", "carefully", "nested", "plain", "inline", "final", "second", "well-known", "x-ray",
+	"snake_case", "e=mc^2", "C++", "2024", "v1.2", "(see", "below)", "etc.", "i.e.", "fast,", "small;",
+};
+
+static const char emphasis_delimiters[] = "*+~-=^_`";
+
+static const char *const code_lines[] = {
+	"int main(int argc, char *argv[]) {",
+	"\tfor (size_t i = 0; i < count; ++i) {",
+	"\t\ttotal += values[i] * weights[i];",
+	"\t}",
+	"\treturn total > 0 ? 0 : 1; // *not* emphasis",
+	"}",
+	"",
+	"#define SQUARE(x) ((x) * (x))",
+	"static const char *name = \"`quoted` +text+\";",
+};
+
+typedef struct Generator {
+	FILE *file;
+	uint64_t state;
+	size_t heading_count;
+} Generator;
+
+static uint64_t next_random(Generator *generator) { // xorshift64*
+	generator->state ^= generator->state >> 12;
+	generator->state ^= generator->state << 25;
+	generator->state ^= generator->state >> 27;
+	return generator->state * 0x2545F4914F6CDD1DULL;
+}
+
+static unsigned int random_below(Generator *generator, unsigned int bound) {
+	return (unsigned int)((next_random(generator) >> 32) % bound);
+}
+
+static unsigned int random_between(Generator *generator, unsigned int low, unsigned int high) {
+	return low + random_below(generator, high - low + 1);
+}
+
+static void write_text(Generator *generator, const char *text) {
+	fputs(text, generator->file);
+}
+
+static void write_indent(Generator *generator, unsigned int spaces) {
+	for (unsigned int i = 0; i < spaces; ++i) {
+		fputc(' ', generator->file);
+	}
+}
+
+static const char *random_word(Generator *generator) {
+	return words[random_below(generator, sizeof(words) / sizeof(words[0]))];
+}
+
+/**
+ * @brief Writes a sentence (without a newline) in which some words are emphasized
+ *
+ * @param emphasis_percent The chance of each word opening an emphasis span, which may cover several words
+ */
+static void write_sentence(Generator *generator, unsigned int emphasis_percent) {
+	unsigned int word_count = random_between(generator, 6, 16);
+	char delimiter = 0;
+	unsigned int words_left_in_span = 0;
+
+	for (unsigned int i = 0; i < word_count; ++i) {
+		if (i > 0) {
+			fputc(' ', generator->file);
+		}
+		if (!delimiter && random_below(generator, 100) < emphasis_percent) {
+			delimiter = emphasis_delimiters[random_below(generator, sizeof(emphasis_delimiters) - 1)];
+			words_left_in_span = random_between(generator, 1, 3);
+			fputc(delimiter, generator->file);
+		}
+		write_text(generator, random_word(generator));
+		if (delimiter && (--words_left_in_span == 0 || i + 1 == word_count)) {
+			fputc(delimiter, generator->file);
+			delimiter = 0;
+		}
+	}
+	fputc('.', generator->file);
+}
+
+static void write_paragraph(Generator *generator, unsigned int emphasis_percent) {
+	unsigned int line_count = random_between(generator, 1, 3);
+	for (unsigned int i = 0; i < line_count; ++i) {
+		write_sentence(generator, emphasis_percent);
+		if (random_below(generator, 2)) {
+			fputc(' ', generator->file);
+			write_sentence(generator, emphasis_percent);
+		}
+		fputc('\n', generator->file);
+	}
+	fputc('\n', generator->file);
+}
+
+static void write_heading(Generator *generator) {
+	unsigned int level = random_between(generator, 1, 6);
+	for (unsigned int i = 0; i < level; ++i) {
+		fputc('#', generator->file);
+	}
+	fputc(' ', generator->file);
+
+	unsigned int word_count = random_between(generator, 2, 6);
+	for (unsigned int i = 0; i < word_count; ++i) {
+		fprintf(generator->file, (i > 0) ? " %s" : "%s", random_word(generator));
+	}
+	if (random_below(generator, 3) == 0) {
+		fprintf(generator->file, " {section-%zu}", generator->heading_count);
+	}
+	++generator->heading_count;
+	fputc('\n', generator->file);
+	write_paragraph(generator, 5);
+}
+
+static void write_list(Generator *generator, unsigned int depth, unsigned int max_depth) {
+	int is_ordered = random_below(generator, 3) == 0;
+	unsigned int item_count = random_between(generator, 2, 5);
+
+	for (unsigned int i = 0; i < item_count; ++i) {
+		write_indent(generator, 2 * depth);
+		if (is_ordered) {
+			fprintf(generator->file, "%u. ", i + 1);
+		} else {
+			write_text(generator, "- ");
+		}
+		write_sentence(generator, 10);
+		fputc('\n', generator->file);
+
+		if (random_below(generator, 4) == 0) { // Continuation line
+			write_indent(generator, 2 * (depth + 1));
+			write_sentence(generator, 10);
+			fputc('\n', generator->file);
+		}
+		if (depth + 1 < max_depth && random_below(generator, 3) == 0) {
+			write_list(generator, depth + 1, max_depth);
+		}
+	}
+}
+
+static void write_quote(Generator *generator) {
+	unsigned int line_count = random_between(generator, 1, 4);
+	for (unsigned int i = 0; i < line_count; ++i) {
+		write_text(generator, random_below(generator, 4) ? "> " : ">> ");
+		write_sentence(generator, 10);
+		fputc('\n', generator->file);
+	}
+	fputc('\n', generator->file);
+}
+
+static void write_code(Generator *generator) {
+	write_text(generator, random_below(generator, 2) ? "``c\n" : "``\n");
+	unsigned int line_count = random_between(generator, 3, 20);
+	for (unsigned int i = 0; i < line_count; ++i) {
+		write_text(generator, code_lines[random_below(generator, sizeof(code_lines) / sizeof(code_lines[0]))]);
+		fputc('\n', generator->file);
+	}
+	write_text(generator, "``\n\n");
+}
+
+static void write_columns(Generator *generator) {
+	write_text(generator, "[|\n");
+	write_paragraph(generator, 10);
+	write_text(generator, "||\n");
+	write_paragraph(generator, 10);
+	write_text(generator, "|]\n\n");
+}
+
+static void write_description(Generator *generator) {
+	unsigned int key_count = random_between(generator, 1, 4);
+	for (unsigned int i = 0; i < key_count; ++i) {
+		fprintf(generator->file, "Term %s\n", random_word(generator));
+		unsigned int value_count = random_between(generator, 1, 3);
+		for (unsigned int j = 0; j < value_count; ++j) {
+			write_text(generator, ": ");
+			write_sentence(generator, 10);
+			fputc('\n', generator->file);
+		}
+	}
+	fputc('\n', generator->file);
+}
+
+static void write_unclosed(Generator *generator) { // Openers which are never closed, each of which is scanned for a closer
+	unsigned int word_count = random_between(generator, 50, 200);
+	for (unsigned int i = 0; i < word_count; ++i) {
+		fputc(emphasis_delimiters[random_below(generator, sizeof(emphasis_delimiters) - 1)], generator->file);
+		write_text(generator, random_word(generator));
+		fputc(' ', generator->file);
+	}
+	write_text(generator, "end\n\n");
+}
+
+static void write_long_line(Generator *generator) {
+	size_t length = 0;
+	while (length < LONG_LINE_LENGTH) {
+		const char *word = random_word(generator);
+		char delimiter = emphasis_delimiters[random_below(generator, sizeof(emphasis_delimiters) - 1)];
+		fprintf(generator->file, "%c%s ", delimiter, word);
+		length += strlen(word) + 2;
+	}
+	write_text(generator, "end\n\n");
+}
+
+static void write_deep_list(Generator *generator) {
+	for (unsigned int depth = 0; depth < DEEP_NESTING_LEVELS; ++depth) {
+		write_indent(generator, 2 * depth);
+		write_text(generator, "- ");
+		write_sentence(generator, 10);
+		fputc('\n', generator->file);
+	}
+	fputc('\n', generator->file);
+}
+
+static void write_deep_quote(Generator *generator) {
+	unsigned int line_count = random_between(generator, 2, 8);
+	for (unsigned int i = 0; i < line_count; ++i) {
+		for (unsigned int depth = 0; depth < DEEP_NESTING_LEVELS; ++depth) {
+			fputc('>', generator->file);
+		}
+		fputc(' ', generator->file);
+		write_sentence(generator, 10);
+		fputc('\n', generator->file);
+	}
+	fputc('\n', generator->file);
+}
+
+static void write_repeated_heading(Generator *generator) { // Every heading needs an identifier distinct from the last
+	write_text(generator, "# Notes\n\n");
+}
+
+static void write_block(Generator *generator, BlockKind kind) {
+	switch (kind) {
+		case PROSE_BLOCK: write_paragraph(generator, 5); break;
+		case EMPHASIS_BLOCK: write_paragraph(generator, 60); break;
+		case HEADING_BLOCK: write_heading(generator); break;
+		case LIST_BLOCK: write_list(generator, 0, MAX_LIST_DEPTH); fputc('\n', generator->file); break;
+		case QUOTE_BLOCK: write_quote(generator); break;
+		case CODE_BLOCK: write_code(generator); break;
+		case COLUMN_BLOCK: write_columns(generator); break;
+		case DESCRIPTION_BLOCK: write_description(generator); break;
+		case RULE_BLOCK: write_text(generator, "---\n\n"); break;
+		case UNCLOSED_BLOCK: write_unclosed(generator); break;
+		case LONG_LINE_BLOCK: write_long_line(generator); break;
+		case DEEP_LIST_BLOCK: write_deep_list(generator); break;
+		case DEEP_QUOTE_BLOCK: write_deep_quote(generator); break;
+		case REPEATED_HEADING_BLOCK: write_repeated_heading(generator); break;
+		default: break;
+	}
+}
+
+static BlockKind random_block(Generator *generator, const Mix *mix) {
+	unsigned int total = 0;
+	for (int kind = 0; kind < BLOCK_KIND_COUNT; ++kind) {
+		total += mix->weights[kind];
+	}
+
+	unsigned int choice = random_below(generator, total);
+	for (int kind = 0; kind < BLOCK_KIND_COUNT; ++kind) {
+		if (choice < mix->weights[kind]) {
+			return (BlockKind)kind;
+		}
+		choice -= mix->weights[kind];
+	}
+	return PROSE_BLOCK;
+}
+
+/**
+ * @brief Parses a size in bytes, optionally followed by `K`, `M` or `G` (binary multiples)
+ *
+ * @return int (0 on success, -1 on failure)
+ */
+static int parse_size(const char *argument, size_t *size) {
+	char *end;
+	errno = 0;
+	unsigned long long value = strtoull(argument, &end, 10);
+	if (*argument < '0' || *argument > '9' || errno != 0 || value == 0) {
+		return -1;
+	}
+
+	switch (*end) {
+		case '\0': break;
+		case 'K': case 'k': value <<= 10; ++end; break;
+		case 'M': case 'm': value <<= 20; ++end; break;
+		case 'G': case 'g': value <<= 30; ++end; break;
+		default: return -1;
+	}
+	if (*end != '\0') {
+		return -1;
+	}
+	*size = (size_t)value;
+	return 0;
+}
+
+static void print_usage(const char *program) {
+	fprintf(stderr, "Usage: %s <mix> <size>[K|M|G] <output> [seed]\nMixes:", program);
+	for (size_t i = 0; i < sizeof(mixes) / sizeof(mixes[0]); ++i) {
+		fprintf(stderr, " %s", mixes[i].name);
+	}
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 4 || argc > 5) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	const Mix *mix = NULL;
+	for (size_t i = 0; i < sizeof(mixes) / sizeof(mixes[0]); ++i) {
+		if (strcmp(argv[1], mixes[i].name) == 0) {
+			mix = &mixes[i];
+		}
+	}
+	size_t size;
+	if (mix == NULL || parse_size(argv[2], &size) != 0) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	Generator generator = {NULL, 0x9E3779B97F4A7C15ULL, 0};
+	if (argc == 5) {
+		generator.state ^= strtoull(argv[4], NULL, 10);
+		if (generator.state == 0) { // The only state xorshift never leaves
+			generator.state = 1;
+		}
+	}
+	generator.file = fopen(argv[3], "w");
+	if (generator.file == NULL) {
+		fprintf(stderr, "Error opening output file: %s\n", argv[3]);
+		return 1;
+	}
+
+	// Whole blocks are written until the corpus reaches its size, so it may run over by up to one block
+	while ((size_t)ftell(generator.file) < size) {
+		write_block(&generator, random_block(&generator, mix));
+	}
+
+	if (fclose(generator.file) != 0) {
+		fprintf(stderr, "Error writing output file: %s\n", argv[3]);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "html_escape.h"
+
+#define BENCH_DATA_SIZE (16 * 1024 * 1024)
+#define BENCH_REPETITIONS 8
+
+typedef struct BenchInput {
+	const char *name;
+	size_t special_interval; // Distance between special characters (0 for none)
+} BenchInput;
+
+static const BenchInput inputs[] = {
+	{"clean", 0},
+	{"sparse", 4096},
+	{"prose", 256},
+	{"dense", 16},
+};
+
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void fill_input(char *data, size_t length, size_t special_interval) {
+	static const char specials[] = "&<>\"'";
+	for (size_t i = 0; i < length; ++i) {
+		data[i] = 'a' + (i * 7) % 26;
+		if (i % 61 == 60) {
+			data[i] = ' ';
+		}
+	}
+	if (special_interval > 0) {
+		for (size_t i = special_interval - 1; i < length; i += special_interval) {
+			data[i] = specials[(i / special_interval) % (sizeof(specials) - 1)];
+		}
+	}
+}
+
+/**
+ * @brief Times one scanner escaping the whole input into a memory sink, reporting the best repetition
+ */
+static void bench_scanner(const EscapeScanner *scanner, const char *data, size_t length, EscapeMode mode, OutputSink *sink) {
+	double best = 0;
+	size_t escaped_length = 0;
+	for (int repetition = 0; repetition < BENCH_REPETITIONS; ++repetition) {
+		sink->length = 0;
+
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		size_t offset = 0;
+		while (offset < length) {
+			size_t clean_length = scanner->scan(data + offset, length - offset, mode);
+			sink_write(sink, data + offset, clean_length);
+			offset += clean_length;
+			if (offset < length) {
+				sink_write_escaped(sink, data + offset, 1, mode);
+				++offset;
+			}
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		double seconds = elapsed_seconds(&start, &end);
+		if (repetition == 0 || seconds < best) {
+			best = seconds;
+		}
+		escaped_length = sink->length;
+	}
+
+	printf(
+		"  %-8s %-9s %8.1f MB/s  (%zu -> %zu bytes)\n",
+		scanner->name,
+		(mode == ESCAPE_ATTRIBUTE) ? "attribute" : "text",
+		length / best / 1e6,
+		length,
+		escaped_length
+	);
+}
+
+int main() {
+	char *data = (char *)malloc(BENCH_DATA_SIZE);
+	if (data == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	OutputSink *sink = create_memory_sink();
+
+	const EscapeScanner *scanners;
+	size_t scanner_count = get_escape_scanners(&scanners);
+
+	for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i) {
+		fill_input(data, BENCH_DATA_SIZE, inputs[i].special_interval);
+		printf("%s input:\n", inputs[i].name);
+		for (size_t j = 0; j < scanner_count; ++j) {
+			bench_scanner(&scanners[j], data, BENCH_DATA_SIZE, ESCAPE_TEXT, sink);
+			bench_scanner(&scanners[j], data, BENCH_DATA_SIZE, ESCAPE_ATTRIBUTE, sink);
+		}
+	}
+
+	free_sink(sink);
+	free(data);
+	return 0;
+}
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "arena.h"
+#include "docmark_lexer.h"
+#include "docmark_token.h"
+
+#define BENCH_DATA_SIZE (8 * 1024 * 1024)
+#define BENCH_REPETITIONS 5
+
+#if defined(DOCMARK_FLEX_LEXER)
+#define LEXER_NAME "flex"
+#else
+#define LEXER_NAME "handwritten"
+#endif
+
+typedef struct BenchInput {
+	const char *name;
+	const char *const *blocks; // Repeated in turn until the input is full
+} BenchInput;
+
+static const char *const prose_blocks[] = {
+	"Plain prose with *italic*, +bold+ and `code` spans, as well as well-known x-ray words.\n",
+	"# A heading {heading-id}\n",
+	"Another paragraph of e=mc^2 and snake_case_names which open no spans at all.\n",
+	"\n",
+	NULL,
+};
+
+static const char *const block_blocks[] = {
+	"- An item with *emphasis*\n  - A nested item\n    1. Deeper still\n    2. And its sibling\n  - Back up a level\n",
+	"> A quotation\n> across two lines\n",
+	"Term\n: Its definition\n: And another\n",
+	"``c\nint main() {}\n``\n",
+	"[|\nLeft\n||\nRight\n|]\n",
+	"---\n",
+	NULL,
+};
+
+static const BenchInput inputs[] = {
+	{"prose", prose_blocks},
+	{"blocks", block_blocks},
+};
+
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Fills the input with whole blocks, padded as a source buffer would be
+ *
+ * @return size_t The length of the document, including its final newline
+ */
+static size_t fill_input(char *data, size_t capacity, const char *const *blocks) {
+	size_t length = 0;
+	for (size_t i = 0; ; i = blocks[i + 1] ? i + 1 : 0) {
+		size_t block_length = strlen(blocks[i]);
+		if (length + block_length + 1 > capacity) {
+			break;
+		}
+		memcpy(data + length, blocks[i], block_length);
+		length += block_length;
+	}
+	data[length++] = '\n';
+	data[length] = '\0';
+	data[length + 1] = '\0';
+	return length;
+}
+
+/**
+ * @brief Times lexing the whole input into a fresh tree, reporting the best repetition
+ */
+static void bench_input(const BenchInput *input, char *data, Arena *arena, TokenTree *tree) {
+	size_t length = fill_input(data, BENCH_DATA_SIZE, input->blocks);
+
+	double best = 0;
+	size_t token_count = 0;
+	for (int repetition = 0; repetition < BENCH_REPETITIONS; ++repetition) {
+		reset_arena(arena);
+		reset_token_tree(tree);
+
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		DocmarkLexContext *context = create_lex_context(arena, tree);
+		lex_document(context, root_token(tree, data, length));
+		free_lex_context(context);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		double seconds = elapsed_seconds(&start, &end);
+		if (repetition == 0 || seconds < best) {
+			best = seconds;
+		}
+		token_count = tree->count;
+	}
+
+	printf("  %-11s %-7s %8.1f MB/s  (%zu bytes -> %zu tokens)\n", LEXER_NAME, input->name, length / best / 1e6, length, token_count);
+}
+
+int main() {
+	char *data = (char *)malloc(BENCH_DATA_SIZE + 2); // Room for the sentinels
+	if (data == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	Arena *arena = create_arena(0, 0);
+	TokenTree *tree = create_token_tree();
+
+	for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i) {
+		bench_input(&inputs[i], data, arena, tree);
+	}
+
+	free_token_tree(tree);
+	free_arena(arena);
+	free(data);
+	return 0;
+}
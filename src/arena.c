@@ -0,0 +1,147 @@
+#include "arena.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define ARENA_ALIGNMENT _Alignof(max_align_t)
+#define ALIGN_UP(size, alignment) (((size) + (alignment) - 1) & ~((size_t)(alignment) - 1))
+#define CHUNK_HEADER_SIZE ALIGN_UP(sizeof(ArenaChunk), ARENA_ALIGNMENT)
+
+Arena *create_arena(size_t chunk_size, int use_huge_pages) {
+	Arena *arena = (Arena *)malloc(sizeof(Arena));
+	if (arena == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+
+	arena->first = NULL;
+	arena->current = NULL;
+	arena->chunk_size = (chunk_size == 0) ? ARENA_DEFAULT_CHUNK_SIZE : chunk_size;
+	arena->use_huge_pages = use_huge_pages;
+	if (use_huge_pages) {
+		arena->chunk_size = ALIGN_UP(arena->chunk_size, ARENA_HUGE_PAGE_SIZE);
+	}
+	return arena;
+}
+
+/**
+ * @brief Maps a chunk from huge pages, falling back to transparent huge pages and then to the heap
+ */
+static void *map_huge_chunk(size_t mapping_size) {
+	void *memory;
+#ifdef MAP_HUGETLB
+	memory = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (memory != MAP_FAILED) {
+		return memory;
+	}
+#endif
+
+	memory = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED) {
+		return NULL;
+	}
+#ifdef MADV_HUGEPAGE
+	madvise(memory, mapping_size, MADV_HUGEPAGE);
+#endif
+	return memory;
+}
+
+static ArenaChunk *create_chunk(Arena *arena, size_t minimum_size) {
+	size_t mapping_size = arena->chunk_size;
+	if (minimum_size + CHUNK_HEADER_SIZE > mapping_size) { // Oversized allocations get a chunk of their own
+		mapping_size = minimum_size + CHUNK_HEADER_SIZE;
+		if (arena->use_huge_pages) {
+			mapping_size = ALIGN_UP(mapping_size, ARENA_HUGE_PAGE_SIZE);
+		}
+	}
+
+	ArenaChunk *chunk = NULL;
+	int is_mapped = 0;
+	if (arena->use_huge_pages) {
+		chunk = (ArenaChunk *)map_huge_chunk(mapping_size);
+		is_mapped = (chunk != NULL);
+	}
+	if (chunk == NULL) {
+		chunk = (ArenaChunk *)malloc(mapping_size);
+		if (chunk == NULL) {
+			fprintf(stderr, "ERROR: Memory allocation failed\n");
+			exit(1);
+		}
+	}
+
+	chunk->next = NULL;
+	chunk->size = mapping_size - CHUNK_HEADER_SIZE;
+	chunk->used = 0;
+	chunk->is_mapped = is_mapped;
+	return chunk;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+	size = ALIGN_UP(size, ARENA_ALIGNMENT);
+
+	ArenaChunk *chunk = arena->current;
+	while (chunk && chunk->used + size > chunk->size) {
+		chunk = chunk->next; // Chunks past the current one have not been used since the last reset
+	}
+
+	if (chunk == NULL) {
+		chunk = create_chunk(arena, size);
+		if (arena->current) {
+			chunk->next = arena->current->next;
+			arena->current->next = chunk;
+		} else {
+			arena->first = chunk;
+		}
+	}
+	arena->current = chunk;
+
+	void *memory = (char *)chunk + CHUNK_HEADER_SIZE + chunk->used;
+	chunk->used += size;
+	return memory;
+}
+
+char *arena_strndup(Arena *arena, const char *string, size_t length) {
+	char *copy = (char *)arena_alloc(arena, length + 1);
+	memcpy(copy, string, length);
+	copy[length] = '\0';
+	return copy;
+}
+
+char *arena_strdup(Arena *arena, const char *string) {
+	return arena_strndup(arena, string, strlen(string));
+}
+
+void reset_arena(Arena *arena) {
+	for (ArenaChunk *chunk = arena->first; chunk; chunk = chunk->next) {
+		chunk->used = 0;
+	}
+	arena->current = arena->first;
+}
+
+size_t arena_allocated_bytes(const Arena *arena) {
+	size_t bytes = 0;
+	for (const ArenaChunk *chunk = arena->first; chunk; chunk = chunk->next) {
+		bytes += chunk->used;
+	}
+	return bytes;
+}
+
+void free_arena(Arena *arena) {
+	if (arena == NULL) {
+		return;
+	}
+
+	ArenaChunk *chunk = arena->first;
+	while (chunk) {
+		ArenaChunk *next = chunk->next;
+		if (chunk->is_mapped) {
+			munmap(chunk, chunk->size + CHUNK_HEADER_SIZE);
+		} else {
+			free(chunk);
+		}
+		chunk = next;
+	}
+	free(arena);
+}
@@ -0,0 +1,70 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+
+#define ARENA_DEFAULT_CHUNK_SIZE 65536
+#define ARENA_HUGE_PAGE_SIZE 2097152
+
+typedef struct ArenaChunk {
+	struct ArenaChunk *next;
+	size_t size; // Usable bytes following the header
+	size_t used;
+	int is_mapped;
+} ArenaChunk;
+
+typedef struct Arena {
+	ArenaChunk *first;
+	ArenaChunk *current;
+	size_t chunk_size;
+	int use_huge_pages;
+} Arena;
+
+/**
+ * @brief Creates a bump allocator whose allocations are all released together
+ *
+ * @param chunk_size The size of each chunk requested from the system (0 for the default)
+ * @param use_huge_pages Whether chunks should be backed by huge pages where the system allows it
+ * @return Arena*
+ */
+Arena *create_arena(size_t chunk_size, int use_huge_pages);
+
+/**
+ * @brief Allocates suitably aligned memory which lives until the arena is reset or freed
+ *
+ * @param arena The arena to allocate from
+ * @param size The number of bytes to be allocated
+ * @return void*
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * @brief Copies `length` bytes of a string into the arena and NUL-terminates the copy
+ *
+ * @param arena The arena to allocate from
+ * @param string The string to be copied
+ * @param length The number of bytes to be copied
+ * @return char*
+ */
+char *arena_strndup(Arena *arena, const char *string, size_t length);
+
+char *arena_strdup(Arena *arena, const char *string);
+
+/**
+ * @brief Releases every allocation at once, keeping the chunks for reuse
+ *
+ * @param arena The arena to be reset
+ */
+void reset_arena(Arena *arena);
+
+/**
+ * @brief Totals the bytes allocated since the arena was created or last reset, including alignment
+ *
+ * @param arena The arena to be measured
+ * @return size_t
+ */
+size_t arena_allocated_bytes(const Arena *arena);
+
+void free_arena(Arena *arena);
+
+#endif
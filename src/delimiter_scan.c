@@ -0,0 +1,68 @@
+#include "delimiter_scan.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static const unsigned char delimiter_table[256] = {
+	['*'] = 1,
+	['+'] = 1,
+	['~'] = 1,
+	['-'] = 1,
+	['='] = 1,
+	['^'] = 1,
+	['_'] = 1,
+	['`'] = 1,
+	['\n'] = 1,
+};
+
+size_t find_inline_delimiter(const char *data, size_t length) {
+	size_t i = 0;
+
+#if defined(__SSE2__) // Part of every x86-64 processor, so no runtime check is needed
+	const __m128i asterisk = _mm_set1_epi8('*');
+	const __m128i plus = _mm_set1_epi8('+');
+	const __m128i tilde = _mm_set1_epi8('~');
+	const __m128i dash = _mm_set1_epi8('-');
+	const __m128i equals = _mm_set1_epi8('=');
+	const __m128i newline = _mm_set1_epi8('\n');
+	const __m128i caret_to_backtick = _mm_set1_epi8('^' - 1); // `^`, `_` and the backtick are consecutive
+	const __m128i range_top = _mm_set1_epi8('`' + 1);
+
+	for (; i + 16 <= length; i += 16) {
+		__m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+		__m128i matches = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(block, asterisk), _mm_cmpeq_epi8(block, plus)),
+			_mm_or_si128(_mm_cmpeq_epi8(block, tilde), _mm_cmpeq_epi8(block, dash))
+		);
+		matches = _mm_or_si128(
+			matches,
+			_mm_or_si128(_mm_cmpeq_epi8(block, equals), _mm_cmpeq_epi8(block, newline))
+		);
+		// Signed comparisons suffice, as bytes from 0x80 upwards are negative and fall outside the range
+		matches = _mm_or_si128(
+			matches,
+			_mm_and_si128(_mm_cmpgt_epi8(block, caret_to_backtick), _mm_cmplt_epi8(block, range_top))
+		);
+
+		int mask = _mm_movemask_epi8(matches);
+		if (mask != 0) {
+			return i + __builtin_ctz(mask);
+		}
+	}
+#endif
+
+	for (; i < length; ++i) {
+		if (delimiter_table[(unsigned char)data[i]]) {
+			return i;
+		}
+	}
+	return length;
+}
+
+size_t find_line_end(const char *data, size_t length) {
+	const char *line_end = memchr(data, '\n', length);
+	return (line_end == NULL) ? length : (size_t)(line_end - data);
+}
@@ -0,0 +1,28 @@
+#ifndef DELIMITER_SCAN_H
+#define DELIMITER_SCAN_H
+
+#include <stdlib.h>
+
+/**
+ * @brief Finds the first character which could begin inline markup or end a line
+ *
+ * The delimiters are the first characters of the inline rules (`*+~-=^_` and
+ * the backtick) and the newline; everything before the first of them is plain
+ * text, which no rule but RAW_DATA can match.
+ *
+ * @param data The data to be scanned
+ * @param length The number of bytes to be scanned
+ * @return size_t The index of the first delimiter (`length` if there is none)
+ */
+size_t find_inline_delimiter(const char *data, size_t length);
+
+/**
+ * @brief Finds the end of the first line
+ *
+ * @param data The data to be scanned
+ * @param length The number of bytes to be scanned
+ * @return size_t The index of the first newline (`length` if there is none)
+ */
+size_t find_line_end(const char *data, size_t length);
+
+#endif
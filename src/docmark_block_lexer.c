@@ -0,0 +1,568 @@
+#include "docmark_block_lexer.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "delimiter_scan.h"
+#include "docmark_debug.h"
+#include "docmark_definitions.h"
+#include "docmark_inline_lexer.h"
+#include "docmark_line_classes.h"
+
+#define INITIAL_LINE_CAPACITY 256
+#define INITIAL_FRAME_CAPACITY 16
+
+/**
+ * @brief A line of a block: a line of the source, less the list markers and indentation of the lists enclosing it
+ */
+typedef struct BlockLine {
+	const char *start;
+	size_t length; // Excluding the newline
+	int has_newline; // Only the last line of a list element has none
+	unsigned int classes; // The LineClass flags of the line (none without a newline, as every block rule needs one)
+} BlockLine;
+
+typedef enum BlockKind {
+	DOCUMENT_BLOCK,
+	ELEMENT_BLOCK,
+	LIST_BLOCK, // Opens the elements of a list one at a time
+} BlockKind;
+
+typedef struct BlockFrame {
+	BlockKind kind;
+	TokenType list_type; // The type of a list block
+	TokenId token; // Receives the tokens of the block
+	size_t next_line; // The block's remaining lines
+	size_t end_line;
+} BlockFrame;
+
+typedef struct BlockLexer {
+	DocmarkLexContext *context;
+	TokenTree *tree;
+	const char *text; // The source, which every token views
+
+	// The lines of the document, which are stripped in place of the list markers and indentation of each list element
+	BlockLine *lines;
+	size_t line_count;
+	size_t line_capacity;
+
+	BlockFrame *frames;
+	size_t frame_count;
+	size_t frame_capacity;
+} BlockLexer;
+
+/**
+ * @brief The block rules, in order of precedence when matches are equally long
+ */
+typedef enum BlockRule {
+	NO_RULE,
+	HORIZONTAL_RULE_RULE,
+	HEADING_RULE,
+	BLOCKQUOTE_RULE,
+	ORDERED_LIST_RULE,
+	UNORDERED_LIST_RULE,
+	DESCRIPTION_LIST_RULE,
+	CODE_BLOCK_RULE,
+	COLUMN_RULE,
+} BlockRule;
+
+static void *grow_stack(void *stack, size_t *capacity, size_t initial_capacity, size_t size) {
+	*capacity = (*capacity == 0) ? initial_capacity : *capacity * 2;
+	stack = realloc(stack, *capacity * size);
+	if (stack == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	return stack;
+}
+
+static void set_line(BlockLine *line, const char *start, size_t length, int has_newline, int is_document) {
+	unsigned int classes = has_newline ? classify_line(start, length, is_document) : 0;
+	*line = (BlockLine){start, length, has_newline, classes};
+}
+
+static void push_line(BlockLexer *lexer, const char *start, size_t length, int has_newline) {
+	if (lexer->line_count == lexer->line_capacity) {
+		lexer->lines = grow_stack(lexer->lines, &lexer->line_capacity, INITIAL_LINE_CAPACITY, sizeof(BlockLine));
+	}
+	set_line(&lexer->lines[lexer->line_count++], start, length, has_newline, 1);
+}
+
+static void push_frame(BlockLexer *lexer, BlockKind kind, TokenType list_type, TokenId token, size_t first_line, size_t end_line) {
+	if (lexer->frame_count == lexer->frame_capacity) {
+		lexer->frames = grow_stack(lexer->frames, &lexer->frame_capacity, INITIAL_FRAME_CAPACITY, sizeof(BlockFrame));
+	}
+	lexer->frames[lexer->frame_count++] = (BlockFrame){kind, list_type, token, first_line, end_line};
+}
+
+static Span span_of(BlockLexer *lexer, const char *start, size_t length) {
+	return (Span){(unsigned int)(start - lexer->text), (unsigned int)length};
+}
+
+/**
+ * @brief Adds a token whose data is not lexed any further
+ */
+static TokenId add_lexed(BlockLexer *lexer, TokenType type, const char *start, size_t length, TokenId parent) {
+	TokenId token = add_child(lexer->tree, type, lexer->text, span_of(lexer, start, length), EMPTY_SPAN, 0, parent);
+	mark_raw(lexer->tree, token);
+	return token;
+}
+
+/**
+ * @brief Adds a token which has no text of its own
+ */
+static TokenId add_marker(BlockLexer *lexer, TokenType type, TokenId parent) {
+	TokenId token = add_child(lexer->tree, type, NULL, EMPTY_SPAN, EMPTY_SPAN, 0, parent);
+	mark_raw(lexer->tree, token);
+	return token;
+}
+
+static int is_blank(char character) {
+	return character == ' ' || character == '\t';
+}
+
+static void add_paragraph(BlockLexer *lexer, const char *start, size_t length, TokenId parent) {
+	if (length <= 1) {
+		return; // Single characters have never formed paragraphs
+	}
+
+	if (is_blank(*start)) {
+		while (length > 0 && is_blank(*start)) {
+			++start;
+			--length;
+		}
+		add_lexed(lexer, INDENTED_PARAGRAPH, start, length, parent);
+	} else {
+		TokenId paragraph = add_child(lexer->tree, PARAGRAPH, lexer->text, span_of(lexer, start, length), EMPTY_SPAN, 0, parent);
+		++lexer->context->lex_calls;
+		lex_inline_token(lexer->tree, paragraph);
+	}
+}
+
+static int is_quote_line(const BlockLine *line) {
+	return line->classes & QUOTE_LINE;
+}
+
+static int is_ordered_item(const BlockLine *line) {
+	return line->classes & ORDERED_ITEM_LINE;
+}
+
+static int is_unordered_item(const BlockLine *line) {
+	return line->classes & UNORDERED_ITEM_LINE;
+}
+
+static int is_continuation(const BlockLine *line) {
+	return line->classes & CONTINUATION_LINE;
+}
+
+static int is_description_key(const BlockLine *line) {
+	return line->classes & DESCRIPTION_KEY_LINE;
+}
+
+static int is_description_value(const BlockLine *line) {
+	return line->classes & DESCRIPTION_VALUE_LINE;
+}
+
+/**
+ * @brief Counts the lines of a list from its first item onwards
+ */
+static size_t match_list(const BlockLine *lines, size_t count, int (*is_item)(const BlockLine *)) {
+	if (count == 0 || !is_item(&lines[0])) {
+		return 0;
+	}
+	size_t matched = 1;
+	while (matched < count && (is_item(&lines[matched]) || is_continuation(&lines[matched]))) {
+		++matched;
+	}
+	return matched;
+}
+
+/**
+ * @brief Counts the lines of a description list, in which every key is followed by at least one value
+ */
+static size_t match_description_list(const BlockLine *lines, size_t count) {
+	size_t matched = 0;
+	while (matched + 1 < count && is_description_key(&lines[matched]) && is_description_value(&lines[matched + 1])) {
+		matched += 2;
+		while (matched < count && is_description_value(&lines[matched])) {
+			++matched;
+		}
+	}
+	return matched;
+}
+
+static size_t match_quote(const BlockLine *lines, size_t count) {
+	size_t matched = 0;
+	while (matched < count && is_quote_line(&lines[matched])) {
+		++matched;
+	}
+	return matched;
+}
+
+/**
+ * @brief Measures lines as the scanner saw them, newlines included
+ */
+static size_t measure_lines(const BlockLine *lines, size_t count) {
+	size_t length = 0;
+	for (size_t i = 0; i < count; ++i) {
+		length += lines[i].length + 1;
+	}
+	return length;
+}
+
+/**
+ * @brief Measures a line which matches a rule as a whole, excluding its newline
+ */
+static size_t match_whole_line(const BlockLine *line, LineClass line_class) {
+	return (line->classes & line_class) ? line->length : 0;
+}
+
+/**
+ * @brief Matches the hashes and whitespace which begin a heading
+ *
+ * @return size_t The length of the prefix (0 if the line does not begin a heading)
+ */
+static size_t match_heading_prefix(const BlockLine *line, unsigned int *rank) {
+	size_t i = 0;
+	while (i < line->length && line->start[i] == '#') {
+		++i;
+	}
+	if (i == 0 || i > 6 || i == line->length || !is_blank(line->start[i])) {
+		return 0;
+	}
+
+	*rank = (unsigned int)i;
+	while (i < line->length && is_blank(line->start[i])) {
+		++i;
+	}
+	return i;
+}
+
+static int is_line(const BlockLine *line, const char *text) {
+	size_t length = strlen(text);
+	return line->length == length && memcmp(line->start, text, length) == 0;
+}
+
+/**
+ * @brief Splits a heading into its text and, if it ends with one in braces, its identifier
+ */
+static void add_heading(BlockLexer *lexer, const char *heading, size_t length, unsigned int rank, TokenId parent) {
+	Span attribute = EMPTY_SPAN;
+	size_t data_length = length;
+
+	// `<text> {<identifier>}`, where the identifier begins with a letter
+	const char *brace = NULL;
+	for (size_t i = length; i > 0; --i) {
+		if (heading[i - 1] == '{') {
+			brace = heading + i - 1;
+			break;
+		}
+	}
+	if (brace && length > 0 && heading[length - 1] == '}' && brace - heading >= 2 && is_blank(brace[-1])) {
+		const char *identifier = brace + 1;
+		const char *end = heading + length - 1;
+		while (identifier < end && is_blank(*identifier)) {
+			++identifier;
+		}
+		const char *identifier_end = identifier;
+		if (identifier_end < end && ((*identifier_end >= 'A' && *identifier_end <= 'Z') || (*identifier_end >= 'a' && *identifier_end <= 'z'))) {
+			++identifier_end;
+			while (identifier_end < end && (isalnum((unsigned char)*identifier_end) || (*identifier_end != '\0' && strchr("-_:.", *identifier_end)))) {
+				++identifier_end;
+			}
+			const char *closing = identifier_end;
+			while (closing < end && is_blank(*closing)) {
+				++closing;
+			}
+			if (closing == end) {
+				attribute = span_of(lexer, identifier, identifier_end - identifier);
+				data_length = brace - 1 - heading;
+			}
+		}
+	}
+
+	while (data_length > 0 && is_blank(heading[data_length - 1])) {
+		--data_length;
+	}
+
+	TokenId token = add_child(lexer->tree, HEADING, lexer->text, span_of(lexer, heading, data_length), attribute, rank, parent);
+	++lexer->context->lex_calls;
+	lex_inline_token(lexer->tree, token);
+}
+
+/**
+ * @brief Adds a code block, whose lines are kept verbatim until one which reads "``"
+ *
+ * @return size_t The number of lines the code block spans
+ */
+static size_t add_code_block(BlockLexer *lexer, const BlockLine *lines, size_t count, TokenId parent) {
+	add_lexed(lexer, START_CODE_BLOCK, lines[0].start + 2, lines[0].length - 2, parent);
+
+	size_t i = 1;
+	for (; i < count; ++i) {
+		const BlockLine *line = &lines[i];
+		if (line->classes & CODE_BLOCK_END_LINE) {
+			add_marker(lexer, END_CODE_BLOCK, parent);
+			return i + 1;
+		}
+		if (line->has_newline) {
+			add_lexed(lexer, RAW_DATA, line->start, line->length + 1, parent); // Including the newline
+		}
+	}
+	return i;
+}
+
+static void add_column(BlockLexer *lexer, const BlockLine *line, TokenId parent) {
+	DocmarkLexContext *context = lexer->context;
+	if (is_line(line, "[|")) {
+		if (context->in_left_column || context->in_right_column) {
+			add_paragraph(lexer, line->start, line->length, parent);
+		} else {
+			add_marker(lexer, LEFT_COLUMN, parent);
+		}
+		context->in_left_column = 1;
+	} else if (is_line(line, "||")) {
+		if (!context->in_left_column || context->in_right_column) {
+			add_paragraph(lexer, line->start, line->length, parent);
+		} else {
+			add_marker(lexer, DIVIDER_COLUMN, parent);
+		}
+		context->in_left_column = 0;
+		context->in_right_column = 1;
+	} else {
+		if (context->in_left_column || !context->in_right_column) {
+			add_paragraph(lexer, line->start, line->length, parent);
+		} else {
+			add_marker(lexer, RIGHT_COLUMN, parent);
+		}
+		context->in_right_column = 0;
+	}
+}
+
+static void add_quote(BlockLexer *lexer, const BlockLine *lines, size_t count, TokenId parent) {
+	TokenId quote = add_marker(lexer, BLOCKQUOTE, parent);
+	for (size_t i = 0; i < count; ++i) {
+		const char *start = lines[i].start + 1; // Only the first `>` is stripped, so nested quotes stay quoted
+		const char *end = lines[i].start + lines[i].length;
+		while (start < end && is_blank(*start)) {
+			++start;
+		}
+		size_t length = (end - start) + (i + 1 < count); // Lines are separated by their newlines
+		if (length > 0) {
+			add_lexed(lexer, RAW_DATA, start, length, quote);
+		}
+	}
+}
+
+static void add_description_list(BlockLexer *lexer, const BlockLine *lines, size_t count, TokenId parent) {
+	TokenId list = add_marker(lexer, DESCRIPTION_LIST, parent);
+	for (size_t i = 0; i < count; ++i) {
+		const BlockLine *line = &lines[i];
+		if (line->start[0] == ':') {
+			const char *start = line->start + 1;
+			const char *end = line->start + line->length;
+			while (start < end && is_blank(*start)) {
+				++start;
+			}
+			add_lexed(lexer, DESCRIPTION_LIST_VALUE, start, end - start, list);
+		} else {
+			add_lexed(lexer, DESCRIPTION_LIST_KEY, line->start, line->length, list);
+		}
+	}
+}
+
+/**
+ * @brief Lexes the block which begins at the next line of a document or list element
+ *
+ * Where several rules match, the longest match wins, as it would in the scanner;
+ * a line which begins no block is plain text, with inline markup in list elements.
+ */
+static void lex_block_line(BlockLexer *lexer, size_t frame_index) {
+	BlockFrame *frame = &lexer->frames[frame_index];
+	const BlockLine *lines = &lexer->lines[frame->next_line];
+	size_t count = frame->end_line - frame->next_line;
+	TokenId parent = frame->token;
+	int is_document = (frame->kind == DOCUMENT_BLOCK);
+
+	if (lines[0].length == 0) {
+		++frame->next_line;
+		return;
+	}
+
+	BlockRule rule = NO_RULE;
+	size_t best_length = 0;
+	size_t best_lines = 1;
+	unsigned int rank = 0;
+
+	#define CONSIDER(candidate_rule, length, line_count) \
+		do { \
+			size_t candidate_length = (length); \
+			if (candidate_length > best_length) { \
+				rule = (candidate_rule); \
+				best_length = candidate_length; \
+				best_lines = (line_count); \
+			} \
+		} while (0)
+
+	if (is_document) {
+		CONSIDER(HORIZONTAL_RULE_RULE, match_whole_line(&lines[0], HORIZONTAL_RULE_LINE), 1);
+		if (lines[0].classes & HEADING_LINE) {
+			CONSIDER(HEADING_RULE, match_heading_prefix(&lines[0], &rank), 1);
+		}
+	}
+	size_t matched = match_quote(lines, count);
+	CONSIDER(BLOCKQUOTE_RULE, measure_lines(lines, matched), matched);
+	matched = match_list(lines, count, is_ordered_item);
+	CONSIDER(ORDERED_LIST_RULE, measure_lines(lines, matched), matched);
+	matched = match_list(lines, count, is_unordered_item);
+	CONSIDER(UNORDERED_LIST_RULE, measure_lines(lines, matched), matched);
+	matched = match_description_list(lines, count);
+	CONSIDER(DESCRIPTION_LIST_RULE, measure_lines(lines, matched), matched);
+	if (is_document) {
+		CONSIDER(CODE_BLOCK_RULE, match_whole_line(&lines[0], CODE_BLOCK_START_LINE), 1);
+		CONSIDER(COLUMN_RULE, match_whole_line(&lines[0], COLUMN_LINE), 1);
+	}
+
+	#undef CONSIDER
+
+	if (rule == CODE_BLOCK_RULE) {
+		best_lines = add_code_block(lexer, lines, count, parent);
+	}
+	frame->next_line += best_lines; // The frame is not used again, as pushing a list may move it
+
+	switch (rule) {
+		case HORIZONTAL_RULE_RULE:
+			add_marker(lexer, HORIZONTAL_RULE, parent);
+			break;
+		case HEADING_RULE: {
+			size_t prefix = match_heading_prefix(&lines[0], &rank);
+			add_heading(lexer, lines[0].start + prefix, lines[0].length - prefix, rank, parent);
+			break;
+		}
+		case BLOCKQUOTE_RULE:
+			add_quote(lexer, lines, best_lines, parent);
+			break;
+		case ORDERED_LIST_RULE:
+		case UNORDERED_LIST_RULE: {
+			TokenType list_type = (rule == ORDERED_LIST_RULE) ? ORDERED_LIST : UNORDERED_LIST;
+			TokenId list = add_marker(lexer, list_type, parent);
+			size_t first_line = lines - lexer->lines;
+			push_frame(lexer, LIST_BLOCK, list_type, list, first_line, first_line + best_lines);
+			break;
+		}
+		case DESCRIPTION_LIST_RULE:
+			add_description_list(lexer, lines, best_lines, parent);
+			break;
+		case CODE_BLOCK_RULE:
+			break;
+		case COLUMN_RULE:
+			add_column(lexer, &lines[0], parent);
+			break;
+		case NO_RULE:
+			if (is_document) { // No rule but the paragraph's matches within a line of the document
+				add_paragraph(lexer, lines[0].start, lines[0].length, parent);
+			} else {
+				++lexer->context->lex_calls;
+				size_t run_start = lex_inline_line(lexer->tree, lexer->text, lines[0].start, lines[0].length, parent);
+				add_paragraph(lexer, lines[0].start + run_start, lines[0].length - run_start, parent);
+			}
+			break;
+	}
+}
+
+/**
+ * @brief Opens the next element of a list, whose lines lose the list marker or one level of indentation
+ *
+ * Neither the list nor any block around it reads the element's lines again, so
+ * they are stripped in place; copying them instead would keep every level of a
+ * deeply nested list's lines at once, in space quadratic in the depth.
+ */
+static void open_list_element(BlockLexer *lexer, size_t frame_index) {
+	BlockFrame *frame = &lexer->frames[frame_index];
+	size_t item = frame->next_line;
+	size_t end = item + 1;
+	while (end < frame->end_line && is_continuation(&lexer->lines[end])) {
+		++end;
+	}
+	frame->next_line = end;
+	TokenType list_type = frame->list_type;
+	TokenId list = frame->token;
+
+	for (size_t i = item; i < end; ++i) {
+		BlockLine *line = &lexer->lines[i];
+		size_t skipped = 0;
+		if (i == item) {
+			if (list_type == ORDERED_LIST) {
+				while (line->start[skipped] >= '0' && line->start[skipped] <= '9') {
+					++skipped;
+				}
+			}
+			++skipped; // The period or dash
+			while (skipped < line->length && is_blank(line->start[skipped])) {
+				++skipped;
+			}
+		} else {
+			unsigned int spacing = 0;
+			while (skipped < line->length && is_blank(line->start[skipped]) && spacing < TAB_SIZE) {
+				spacing += (line->start[skipped] == ' ') ? 1 : TAB_SIZE;
+				++skipped;
+			}
+		}
+		set_line(line, line->start + skipped, line->length - skipped, i + 1 < end, 0); // The element's trailing newline is not part of it
+	}
+
+	TokenId element = add_marker(lexer, LIST_ELEMENT, list);
+	TRACE_TOKEN(TRACE_LEX, lexer->tree, element);
+	push_frame(lexer, ELEMENT_BLOCK, LIST_ELEMENT, element, item, end);
+}
+
+int lex_blocks(DocmarkLexContext *context, TokenId root) {
+	BlockLexer lexer = {0};
+	lexer.context = context;
+	lexer.tree = context->tree;
+	lexer.text = context->tree->tokens.text[root];
+	context->in_left_column = 0; // Column state must not carry over between documents
+	context->in_right_column = 0;
+	++context->lex_calls;
+	TRACE_TOKEN(TRACE_LEX, lexer.tree, root);
+
+	const char *data = lexer.text + context->tree->tokens.data[root].offset;
+	size_t length = context->tree->tokens.data[root].length;
+	while (length > 0) {
+		size_t line_length = find_line_end(data, length);
+		push_line(&lexer, data, line_length, line_length < length);
+		if (line_length >= length) {
+			break;
+		}
+		data += line_length + 1;
+		length -= line_length + 1;
+	}
+
+	// Each frame's token is one level below the previous frame's, so the stack's height is the depth reached
+	int result = 0;
+	push_frame(&lexer, DOCUMENT_BLOCK, ROOT, root, 0, lexer.line_count);
+	while (lexer.frame_count > 0) {
+		if (lexer.frame_count - 1 > lexer.tree->max_depth) {
+			result = -1;
+			break;
+		}
+
+		size_t top = lexer.frame_count - 1;
+		BlockFrame *frame = &lexer.frames[top];
+		if (frame->next_line == frame->end_line) {
+			--lexer.frame_count;
+		} else if (frame->kind == LIST_BLOCK) {
+			open_list_element(&lexer, top);
+		} else {
+			lex_block_line(&lexer, top);
+		}
+	}
+
+	context->tree->tokens.data[root] = EMPTY_SPAN; // The children now view the data; the text still backs the attribute
+	mark_raw(context->tree, root);
+	free(lexer.lines);
+	free(lexer.frames);
+	return result;
+}
@@ -0,0 +1,22 @@
+#ifndef DOCMARK_BLOCK_LEXER_H
+#define DOCMARK_BLOCK_LEXER_H
+
+#include "docmark_token.h"
+#include "docmark_token_lexers.h"
+
+/**
+ * @brief Lexes a whole document in a single forward pass, without the scanner
+ *
+ * Blocks are tracked on an explicit stack rather than by lexing each token's
+ * data again; nested blocks view the lines of the source with their list
+ * markers and indentation skipped, so no text is copied. Every token of the
+ * resulting tree views the source and is already lexed. Lexing fails if lists
+ * nest beyond the tree's `max_depth`.
+ *
+ * @param context The lexing context of the document being lexed
+ * @param root The root token of the document
+ * @return int (0 on success, -1 on failure)
+ */
+int lex_blocks(DocmarkLexContext *context, TokenId root);
+
+#endif
@@ -0,0 +1,183 @@
+#include "docmark_compiler.h"
+
+#include "docmark_lexer.h"
+#include "docmark_stats.h"
+#include "docmark_token.h"
+#include "generic_parser.h"
+#include "output_sink.h"
+#include "source_buffer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief An output file being written, which only replaces the file at its path once it is complete
+ */
+typedef struct OutputFile {
+	int fd;
+	char *temporary_path; // Renamed over the output path on success (NULL if written in place)
+} OutputFile;
+
+/**
+ * @brief Opens an output file; regular files are written beside their path and renamed into place once
+ * complete with the permissions of the file they replace, so that a failed compilation never leaves a
+ * truncated file behind, while standard output ("-") and special files such as `/dev/null` are written directly
+ *
+ * @return int (0 on success, -1 on failure)
+ */
+static int open_output_file(OutputFile *output, const char *output_path) {
+	static unsigned int temporary_count = 0; // Keeps the temporary names of concurrent jobs apart
+
+	output->temporary_path = NULL;
+	if (strcmp(output_path, "-") == 0) {
+		output->fd = STDOUT_FILENO;
+		return 0;
+	}
+
+	struct stat output_status;
+	int output_exists = (stat(output_path, &output_status) == 0);
+	if (output_exists && !S_ISREG(output_status.st_mode)) {
+		output->fd = open(output_path, O_WRONLY | O_TRUNC);
+		return (output->fd < 0) ? -1 : 0;
+	}
+
+	size_t size = strlen(output_path) + 32;
+	output->temporary_path = (char *)malloc(size);
+	if (output->temporary_path == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	do {
+		unsigned int count = __atomic_fetch_add(&temporary_count, 1, __ATOMIC_RELAXED);
+		snprintf(output->temporary_path, size, "%s.%ld.%u.tmp", output_path, (long)getpid(), count);
+		output->fd = open(output->temporary_path, O_WRONLY | O_CREAT | O_EXCL, 0666); // Written with `writev()`
+	} while (output->fd < 0 && errno == EEXIST);
+
+	if (output->fd < 0) {
+		free(output->temporary_path);
+		return -1;
+	}
+
+	// The file it replaces keeps its permissions
+	if (output_exists && fchmod(output->fd, output_status.st_mode & 07777) != 0) {
+		close(output->fd);
+		unlink(output->temporary_path);
+		free(output->temporary_path);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief Closes an output file, moving it into place if it was written in full
+ *
+ * @param is_complete Whether everything was written; if not, a temporary file is discarded
+ * @return int (0 on success, -1 on failure)
+ */
+static int close_output_file(OutputFile *output, const char *output_path, int is_complete) {
+	int result = 0;
+	if (output->fd != STDOUT_FILENO && close(output->fd) != 0) {
+		result = -1;
+	}
+	if (output->temporary_path) {
+		if (is_complete && result == 0 && rename(output->temporary_path, output_path) != 0) {
+			result = -1;
+		}
+		if (!is_complete || result != 0) {
+			unlink(output->temporary_path);
+		}
+		free(output->temporary_path);
+	}
+	return result;
+}
+
+int compile_file(
+	const char *input_path,
+	const char *output_path,
+	IdentifierArray *heading_identifier_array,
+	IdentifierArray *other_identifier_array,
+	Arena *arena,
+	TokenTree *tree,
+	DocmarkStats *stats
+) {
+	StatsClock clock;
+	if (stats) {
+		start_stats_clock(&clock);
+	}
+
+	SourceBuffer *source;
+	if (strcmp(input_path, "-") == 0) {
+		source = read_source_buffer(stdin);
+	} else {
+		source = open_source_buffer(input_path);
+	}
+	if (!source) {
+		fprintf(stderr, "Error opening input file: %s\n", input_path);
+		return -1;
+	}
+
+	OutputFile output;
+	if (open_output_file(&output, output_path) != 0) {
+		fprintf(stderr, "Error opening output file: %s\n", output_path);
+		free_source_buffer(source);
+		return -1;
+	}
+
+	if (stats) {
+		stats->bytes_read += source->length;
+		record_stats_phase(stats, STATS_READ, &clock);
+	}
+
+	reset_identifier_array(heading_identifier_array);
+	reset_identifier_array(other_identifier_array);
+	reset_arena(arena);
+	reset_token_tree(tree);
+
+	TokenId root = root_token(tree, source->data, source->length);
+	if (root == NO_TOKEN) {
+		fprintf(stderr, "Error: Input is too large (%zu bytes): %s\n", source->length, input_path);
+		close_output_file(&output, output_path, 0);
+		free_source_buffer(source);
+		return -1;
+	}
+	DocmarkLexContext *lex_context = create_lex_context(arena, tree);
+	int nesting_result = lex_document(lex_context, root);
+	if (stats) {
+		stats->lex_calls += lex_context->lex_calls;
+		record_stats_phase(stats, STATS_LEX, &clock);
+	}
+	free_lex_context(lex_context);
+	OutputSink *sink = create_fd_sink(output.fd);
+	if (nesting_result == 0) {
+		order_token_tree(tree);
+		if (stats) {
+			record_stats_phase(stats, STATS_ORDER, &clock);
+		}
+		nesting_result = parse_tree(tree, heading_identifier_array, other_identifier_array, sink);
+		if (stats) {
+			record_stats_phase(stats, STATS_PARSE, &clock);
+		}
+	}
+	int result = free_sink(sink); // The sink borrows from the source, so it must be flushed first
+	int close_result = close_output_file(&output, output_path, result == 0 && nesting_result == 0);
+	if (stats) {
+		record_stats_phase(stats, STATS_WRITE, &clock);
+		count_document_stats(stats, tree, arena, heading_identifier_array, other_identifier_array);
+	}
+
+	if (close_result != 0 || result != 0) {
+		fprintf(stderr, "Error writing output file: %s\n", output_path);
+		result = -1;
+	}
+	if (nesting_result != 0) {
+		fprintf(stderr, "Error: Input nests more than %u levels deep: %s\n", tree->max_depth, input_path);
+		result = -1;
+	}
+	free_source_buffer(source);
+	return result;
+}
@@ -0,0 +1,34 @@
+#ifndef DOCMARK_COMPILER_H
+#define DOCMARK_COMPILER_H
+
+#include "arena.h"
+#include "docmark_stats.h"
+#include "docmark_token.h"
+#include "identifier_array.h"
+
+/**
+ * @brief Compiles a single DocMark document to HTML
+ * 
+ * The identifier arrays, the arena and the token tree are reset before use, so
+ * that they may be reused across documents. Documents which nest beyond the
+ * tree's `max_depth` fail.
+ * 
+ * @param input_path The document to be compiled, or "-" for standard input
+ * @param output_path The file to which the HTML is written, or "-" for standard output; it is only replaced
+ * once the document has compiled in full
+ * @param arena The arena which holds the document's synthesized text
+ * @param tree The tree which holds the document's tokens
+ * @param stats The totals to which the document's timings and counts are added, or NULL
+ * @return int (0 on success, -1 on failure)
+ */
+int compile_file(
+	const char *input_path,
+	const char *output_path,
+	IdentifierArray *heading_identifier_array,
+	IdentifierArray *other_identifier_array,
+	Arena *arena,
+	TokenTree *tree,
+	DocmarkStats *stats
+);
+
+#endif
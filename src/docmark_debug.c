@@ -1,90 +1,147 @@
 #include "docmark_debug.h"
 
 #include <stdio.h>
+#include <string.h>
 
-static void print_null(const char *field, const char *string) {
-	if (string) {
-		printf("\t%s:\n%s\n", field, string);
+#ifdef DOCMARK_TRACE
+unsigned int trace_categories = 0;
+#endif
+
+int set_trace_categories(const char *list) {
+	unsigned int categories = 0;
+	while (*list) {
+		size_t length = strcspn(list, ",");
+		if (length == 3 && strncmp(list, "lex", length) == 0) {
+			categories |= TRACE_LEX;
+		} else if (length == 5 && strncmp(list, "parse", length) == 0) {
+			categories |= TRACE_PARSE;
+		} else if (length == 3 && strncmp(list, "all", length) == 0) {
+			categories |= TRACE_LEX | TRACE_PARSE;
+		} else {
+			fprintf(stderr, "Error: Unknown trace category: %.*s\n", (int)length, list);
+			return -1;
+		}
+		list += length;
+		if (*list == ',') {
+			++list;
+		}
+	}
+
+#ifdef DOCMARK_TRACE
+	trace_categories = categories;
+	return 0;
+#else
+	if (categories) {
+		fprintf(stderr, "Error: Tracing is not compiled in; rebuild with `make TRACE=1`\n");
+		return -1;
+	}
+	return 0;
+#endif
+}
+
+static void print_span(const char *field, const char *text, Span span) {
+	if (text) {
+		fprintf(stderr, "\t%s:\n%.*s\n", field, (int)span.length, text + span.offset);
 	} else {
-		printf("\t%s: NULL\n", field);
+		fprintf(stderr, "\t%s: NULL\n", field);
 	}
 }
 
-static void print_type(TokenType type) {
-	printf("\ttype: ");
+const char *token_type_name(TokenType type) {
+	// Matched against the negated cases, so that marking a token as raw does not change its name; as an int,
+	// since the negated types from HORIZONTAL_RULE to RIGHT_COLUMN are not enumerators
+	int value = (type < 0) ? -(int)type : (int)type;
+
+	switch (value) {
+		case -HORIZONTAL_RULE: return "HORIZONTAL_RULE";
+		case -FOOTNOTE_REFERENCE: return "FOOTNOTE_REFERENCE";
+		case -ENDNOTE_REFERENCE: return "ENDNOTE_REFERENCE";
 
+		case RAW_DATA: return "RAW_DATA";
+
+		case ROOT: return "ROOT";
+		case HEADING: return "HEADING";
+		case ITALIC: return "ITALIC";
+		case BOLD: return "BOLD";
+		case UNDERSCORE: return "UNDERSCORE";
+		case STRIKETHROUGH: return "STRIKETHROUGH";
+		case HIGHLIGHT: return "HIGHLIGHT";
+		case SUPERSCRIPT: return "SUPERSCRIPT";
+		case SUBSCRIPT: return "SUBSCRIPT";
+		case BLOCKQUOTE: return "BLOCKQUOTE";
+		case ORDERED_LIST: return "ORDERED_LIST";
+		case UNORDERED_LIST: return "UNORDERED_LIST";
+		case DESCRIPTION_LIST: return "DESCRIPTION_LIST";
+		case LIST_ELEMENT: return "LIST_ELEMENT";
+		case DESCRIPTION_LIST_KEY: return "DESCRIPTION_LIST_KEY";
+		case DESCRIPTION_LIST_VALUE: return "DESCRIPTION_LIST_VALUE";
+		case INLINE_CODE: return "INLINE_CODE";
+		case -START_CODE_BLOCK: return "START_CODE_BLOCK";
+		case -END_CODE_BLOCK: return "END_CODE_BLOCK";
+		case LINK: return "LINK";
+		case IMAGE: return "IMAGE";
+		case AUDIO: return "AUDIO";
+		case VIDEO: return "VIDEO";
+		case TOP_TITLED_TABLE: return "TOP_TITLED_TABLE";
+		case LEFT_TITLED_TABLE: return "LEFT_TITLED_TABLE";
+		case TWO_WAY_TABLE: return "TWO_WAY_TABLE";
+		case -LEFT_COLUMN: return "LEFT_COLUMN";
+		case -DIVIDER_COLUMN: return "DIVIDER_COLUMN";
+		case -RIGHT_COLUMN: return "RIGHT_COLUMN";
+		case INFOBOX_TITLE: return "INFOBOX_TITLE";
+		case INFOBOX_CONTENT: return "INFOBOX_CONTENT";
+		case FOOTNOTE_NOTE: return "FOOTNOTE_NOTE";
+		case ENDNOTE_NOTE: return "ENDNOTE_NOTE";
+		case PARAGRAPH: return "PARAGRAPH";
+		case INDENTED_PARAGRAPH: return "INDENTED_PARAGRAPH";
+		case VARIABLE_DEFINITION: return "VARIABLE_DEFINITION";
+		case VARIABLE_RETURN: return "VARIABLE_RETURN";
+		case FUNCTION_DEFINITION: return "FUNCTION_DEFINITION";
+		case FUNCTION_RETURN: return "FUNCTION_RETURN";
+		case BUILT_IN_VARIABLE_DEFINITION: return "BUILT_IN_VARIABLE_DEFINITION";
+		case BUILT_IN_VARIABLE_RETURN: return "BUILT_IN_VARIABLE_RETURN";
+		case BUILT_IN_FUNCTION_RETURN: return "BUILT_IN_FUNCTION_RETURN";
+		default: return NULL;
+	}
+}
+
+static void print_type(TokenType type) {
+	fprintf(stderr, "\ttype: ");
 	if (type < 0) {
-		type = -type;
-		printf("RAW ");
+		fprintf(stderr, "RAW ");
 	}
 
-	switch (type) {
-		case -HORIZONTAL_RULE: printf("HORIZONTAL_RULE\n"); break;
-		case -FOOTNOTE_REFERENCE: printf("FOOTNOTE_REFERENCE\n"); break;
-		case -ENDNOTE_REFERENCE: printf("ENDNOTE_REFERENCE\n"); break;
-
-		case RAW_DATA: printf("RAW_DATA\n"); break;
-		
-		case ROOT: printf("ROOT\n"); break;
-		case HEADING: printf("HEADING\n"); break;
-		case ITALIC: printf("ITALIC\n"); break;
-		case BOLD: printf("BOLD\n"); break;
-		case UNDERSCORE: printf("UNDERSCORE\n"); break;
-		case STRIKETHROUGH: printf("STRIKETHROUGH\n"); break;
-		case HIGHLIGHT: printf("HIGHLIGHT\n"); break;
-		case SUPERSCRIPT: printf("SUPERSCRIPT\n"); break;
-		case SUBSCRIPT: printf("SUBSCRIPT\n"); break;
-		case BLOCKQUOTE: printf("BLOCKQUOTE\n"); break;
-		case ORDERED_LIST: printf("ORDERED_LIST\n"); break;
-		case UNORDERED_LIST: printf("UNORDERED_LIST\n"); break;
-		case DESCRIPTION_LIST: printf("DESCRIPTION_LIST\n"); break;
-		case LIST_ELEMENT: printf("LIST_ELEMENT\n"); break;		
-		case DESCRIPTION_LIST_KEY: printf("DESCRIPTION_LIST_KEY\n"); break;
-		case DESCRIPTION_LIST_VALUE: printf("DESCRIPTION_LIST_VALUE\n"); break;
-		case INLINE_CODE: printf("INLINE_CODE\n"); break;
-		case START_CODE_BLOCK: printf("START_CODE_BLOCK\n"); break;
-		case END_CODE_BLOCK: printf("END_CODE_BLOCK\n"); break;
-		case LINK: printf("LINK\n"); break;
-		case IMAGE: printf("IMAGE\n"); break;
-		case AUDIO: printf("AUDIO\n"); break;
-		case VIDEO: printf("VIDEO\n"); break;
-		case TOP_TITLED_TABLE: printf("TOP_TITLED_TABLE\n"); break;
-		case LEFT_TITLED_TABLE: printf("LEFT_TITLED_TABLE\n"); break;
-		case TWO_WAY_TABLE: printf("TWO_WAY_TABLE\n"); break;
-		case LEFT_COLUMN: printf("LEFT_COLUMN\n"); break;
-		case DIVIDER_COLUMN: printf("DIVIDER_COLUMN\n"); break;
-		case RIGHT_COLUMN: printf("RIGHT_COLUMN\n"); break;
-		case INFOBOX_TITLE: printf("INFOBOX_TITLE\n"); break;
-		case INFOBOX_CONTENT: printf("INFOBOX_CONTENT\n"); break;
-		case FOOTNOTE_NOTE: printf("FOOTNOTE_NOTE\n"); break;
-		case ENDNOTE_NOTE: printf("ENDNOTE_NOTE\n"); break;
-		case PARAGRAPH: printf("PARAGRAPH\n"); break;
-		case INDENTED_PARAGRAPH: printf("INDENTED PARAGRAPH\n"); break;
-		case VARIABLE_DEFINITION: printf("VARIABLE_DEFINITION\n"); break;
-		case VARIABLE_RETURN: printf("VARIABLE_RETURN\n"); break;
-		case FUNCTION_DEFINITION: printf("FUNCTION_DEFINITION\n"); break;
-		case FUNCTION_RETURN: printf("FUNCTION_RETURN\n"); break;
-		case BUILT_IN_VARIABLE_DEFINITION: printf("BUILT_IN_VARIABLE_DEFINITION\n"); break;
-		case BUILT_IN_VARIABLE_RETURN: printf("BUILT_IN_VARIABLE_RETURN\n"); break;
-		case BUILT_IN_FUNCTION_RETURN: printf("BUILT_IN_FUNCTION_RETURN\n"); break;
-		default: printf("Unknown Type (%d)\n", type);
+	const char *name = token_type_name(type);
+	if (name) {
+		fprintf(stderr, "%s\n", name);
+	} else {
+		fprintf(stderr, "Unknown Type (%d)\n", (type < 0) ? -type : type);
 	}
 }
 
-void print_token(const char *token_name, Token *token) {
-	printf("{\tToken: %s\n", token_name);
+void print_token(const char *token_name, TokenTree *tree, TokenId token) {
+	flockfile(stderr); // Keep the records of concurrently compiled documents whole
+	fprintf(stderr, "{\tToken: %s\n", token_name);
 
-	if (!token) {
-		printf("\tNULL\n");
-		printf("}\n");
+	if (token == NO_TOKEN) {
+		fprintf(stderr, "\tNULL\n");
+		fprintf(stderr, "}\n");
+		funlockfile(stderr);
 		return;
 	}
 
-	print_type(token->type);
-	print_null("data", token->data);
-	print_null("attribute", token->attribute);
-	printf("\trank: %d\n", token->rank);
-	printf("\tnum_children: %d\n", token->num_children);
+	TokenColumns *tokens = &tree->tokens;
+	unsigned int num_children = 0;
+	for (TokenId child = tokens->first_child[token]; child != NO_TOKEN; child = tokens->next_sibling[child]) {
+		++num_children;
+	}
+
+	print_type(tokens->type[token]);
+	print_span("data", tokens->text[token], tokens->data[token]);
+	print_span("attribute", tokens->attribute[token].length ? tokens->text[token] : NULL, tokens->attribute[token]);
+	fprintf(stderr, "\trank: %d\n", tokens->rank[token]);
+	fprintf(stderr, "\tnum_children: %d\n", num_children);
 
-	printf("}\n");
+	fprintf(stderr, "}\n");
+	funlockfile(stderr);
 }
\ No newline at end of file
@@ -3,6 +3,67 @@
 
 #include "docmark_token.h"
 
-void print_token(const char *token_name, Token *token);
+#include <stdio.h>
 
-#endif
\ No newline at end of file
+/**
+ * @brief The stages which can be traced; each writes one record per token it visits to standard error
+ */
+typedef enum TraceCategory {
+	TRACE_LEX = 1 << 0,
+	TRACE_PARSE = 1 << 1,
+} TraceCategory;
+
+#ifdef DOCMARK_TRACE
+
+extern unsigned int trace_categories; // Set once at startup, before any document is compiled
+
+#define TRACE_ENABLED(category) (trace_categories & (category))
+
+#define TRACE_TOKEN(category, tree, token) \
+	do { \
+		if (TRACE_ENABLED(category)) { \
+			print_token("", tree, token); \
+		} \
+	} while (0)
+
+#define TRACE(category, ...) \
+	do { \
+		if (TRACE_ENABLED(category)) { \
+			fprintf(stderr, __VA_ARGS__); \
+		} \
+	} while (0)
+
+#else // Tracing compiles to nothing
+
+#define TRACE_ENABLED(category) 0
+#define TRACE_TOKEN(category, tree, token) ((void)0)
+#define TRACE(category, ...) ((void)0)
+
+#endif
+
+/**
+ * @brief Enables tracing of the categories in a comma-separated list (`lex`, `parse` or `all`)
+ * 
+ * @param list The list of categories
+ * @return int (0 on success, -1 on failure)
+ */
+int set_trace_categories(const char *list);
+
+/**
+ * @brief Names a token type, whether or not it is marked as raw
+ * 
+ * @param type The type to be named
+ * @return const char* The name of the type (NULL if it is unknown)
+ */
+const char *token_type_name(TokenType type);
+
+/**
+ * @brief Writes a description of a token to standard error
+ * 
+ * @param token_name A label for the token
+ * @param tree The tree which holds the token
+ * @param token The token to be described, or `NO_TOKEN`
+ */
+void print_token(const char *token_name, TokenTree *tree, TokenId token);
+
+#endif
@@ -2,5 +2,6 @@
 #define DOCMARK_LEXING_STANDARDS_H
 
 #define TAB_SIZE 2 // A tab is equivalent to 2 spaces in length
+#define DEFAULT_MAX_DEPTH 4096 // How deeply tokens may nest, unless configured otherwise
 
 #endif
\ No newline at end of file
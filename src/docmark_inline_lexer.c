@@ -0,0 +1,113 @@
+#include "docmark_inline_lexer.h"
+
+#include <string.h>
+
+#include "delimiter_scan.h"
+
+/**
+ * @brief The kind of each inline delimiter, counted from 1 (0 for other characters)
+ */
+static const unsigned char inline_kinds[256] = {
+	['*'] = 1,
+	['+'] = 2,
+	['~'] = 3,
+	['-'] = 4,
+	['='] = 5,
+	['^'] = 6,
+	['_'] = 7,
+	['`'] = 8,
+};
+
+#define INLINE_KIND_COUNT 8
+
+static const TokenType inline_types[INLINE_KIND_COUNT] = {
+	ITALIC,
+	BOLD,
+	UNDERSCORE,
+	STRIKETHROUGH,
+	HIGHLIGHT,
+	SUPERSCRIPT,
+	SUBSCRIPT,
+	INLINE_CODE,
+};
+
+static int is_inline_blank(char character) {
+	return character == ' ' || character == '\t' || character == '\r' || character == '\n';
+}
+
+static Span span_of(const char *text, const char *start, size_t length) {
+	return (Span){(unsigned int)(start - text), (unsigned int)length};
+}
+
+size_t lex_inline_line(TokenTree *tree, const char *text, const char *line, size_t length, TokenId parent) {
+	// A delimiter opens a span when text follows it and a later delimiter of its kind could close one,
+	// by following neither whitespace, a backslash nor another such delimiter; the span then ends at the
+	// very next delimiter of its kind. Recording where the last possible closer of each kind lies before
+	// lexing means that no opener has to search the rest of the line, so lines are lexed in linear time.
+	size_t last_closers[INLINE_KIND_COUNT] = {0}; // A closer never begins a line
+
+	for (size_t position = find_inline_delimiter(line, length); position < length; ) {
+		unsigned int kind = inline_kinds[(unsigned char)line[position]];
+		if (kind && position > 0) {
+			char previous = line[position - 1];
+			if (!is_inline_blank(previous) && previous != '\\' && previous != line[position]) {
+				last_closers[kind - 1] = position;
+			}
+		}
+		++position;
+		position += find_inline_delimiter(line + position, length - position);
+	}
+
+	size_t run_start = 0;
+	for (size_t position = find_inline_delimiter(line, length); position < length; ) {
+		char delimiter = line[position];
+		unsigned int kind = inline_kinds[(unsigned char)delimiter];
+		if (
+			kind &&
+			position + 1 < length &&
+			!is_inline_blank(line[position + 1]) &&
+			line[position + 1] != delimiter &&
+			last_closers[kind - 1] >= position + 2
+		) {
+			const char *closer = memchr(line + position + 2, delimiter, length - position - 2);
+			if (position > run_start) {
+				add_child(tree, RAW_DATA, text, span_of(text, line + run_start, position - run_start), EMPTY_SPAN, 0, parent);
+			}
+
+			TokenType type = inline_types[kind - 1];
+			TokenId span = add_child(tree, type, text, span_of(text, line + position + 1, closer - line - position - 1), EMPTY_SPAN, 0, parent);
+			if (type == INLINE_CODE) {
+				mark_raw(tree, span); // Code is kept verbatim
+			} else {
+				lex_inline_token(tree, span); // Holds no delimiter of its own kind, so at most one level per kind
+			}
+			position = run_start = closer - line + 1;
+		} else {
+			++position;
+		}
+		position += find_inline_delimiter(line + position, length - position);
+	}
+	return run_start;
+}
+
+void lex_inline_token(TokenTree *tree, TokenId token) {
+	const char *text = tree->tokens.text[token];
+	const char *data = text + tree->tokens.data[token].offset;
+	size_t length = tree->tokens.data[token].length;
+
+	for (;;) {
+		size_t line_length = find_line_end(data, length);
+		size_t run_start = lex_inline_line(tree, text, data, line_length, token);
+		if (run_start < line_length) {
+			add_child(tree, RAW_DATA, text, span_of(text, data + run_start, line_length - run_start), EMPTY_SPAN, 0, token);
+		}
+		if (line_length >= length) {
+			break;
+		}
+		data += line_length + 1; // Newlines separate the lines but belong to neither
+		length -= line_length + 1;
+	}
+
+	tree->tokens.data[token] = EMPTY_SPAN;
+	mark_raw(tree, token);
+}
@@ -0,0 +1,34 @@
+#ifndef DOCMARK_INLINE_LEXER_H
+#define DOCMARK_INLINE_LEXER_H
+
+#include "docmark_token.h"
+
+#include <stddef.h>
+
+/**
+ * @brief Adds the inline markup of a single line as children of a token
+ *
+ * Every span of markup is lexed in turn, so the tokens added are complete; the
+ * plain text before each span is added as RAW_DATA, while the plain text which
+ * ends the line is left to the caller.
+ *
+ * @param tree The tree to which tokens are added
+ * @param text The text which the new tokens view
+ * @param line Where the line begins within `text`
+ * @param length The length of the line, excluding any newline
+ * @param parent The token which receives the markup
+ * @return size_t Where the plain text which ends the line begins, relative to `line`
+ */
+size_t lex_inline_line(TokenTree *tree, const char *text, const char *line, size_t length, TokenId parent);
+
+/**
+ * @brief Lexes the data of a token which may only contain inline markup, line by line
+ *
+ * Afterwards the token's data is empty, as its children view it instead.
+ *
+ * @param tree The tree holding the token
+ * @param token The token to be lexed
+ */
+void lex_inline_token(TokenTree *tree, TokenId token);
+
+#endif
@@ -0,0 +1,284 @@
+#include "docmark_lex_profile.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLE_UNIT "cycles"
+
+static uint64_t read_cycles() {
+	return __rdtsc();
+}
+#else
+#define CYCLE_UNIT "ns"
+
+static uint64_t read_cycles() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+#endif
+
+#define LEX_PROFILE_SAMPLE_PERIOD 16 // One match in this many is timed, as reading the clock costs more than most actions
+#define MAX_LEX_RULES 64
+#define MAX_LEX_CONDITIONS 64
+
+typedef struct LexCounters {
+	uint64_t matches;
+	uint64_t bytes;
+	uint64_t backups;
+	uint64_t samples; // Matches which were timed
+	uint64_t scan_cycles; // Spent matching the samples, from the end of the previous action
+	uint64_t action_cycles; // Spent in the samples' actions
+} LexCounters;
+
+/**
+ * @brief The counts of one thread, which are only summed at exit so that the scanner never waits for a lock
+ */
+typedef struct LexProfile {
+	LexCounters rules[MAX_LEX_RULES];
+	LexCounters conditions[MAX_LEX_CONDITIONS];
+	struct LexProfile *next;
+
+	LexCounters *rule; // The counters of the match whose action is running (NULL if none)
+	LexCounters *condition;
+	size_t length;
+	unsigned int countdown; // Matches until the next sample
+	int scan_sampled;
+	int action_sampled;
+	uint64_t scan_start;
+	uint64_t action_start;
+} LexProfile;
+
+static _Thread_local LexProfile *thread_profile = NULL;
+static LexProfile *profiles = NULL;
+static const LexProfileNames *profile_names = NULL;
+static pthread_mutex_t profiles_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void print_lex_profile();
+
+/**
+ * @brief Finds the calling thread's profile, creating it on first use
+ *
+ * @param names The names for the report, which are kept if none were given before (or NULL)
+ */
+static LexProfile *get_profile(const LexProfileNames *names) {
+	if (thread_profile != NULL) {
+		return thread_profile;
+	}
+
+	LexProfile *profile = (LexProfile *)calloc(1, sizeof(LexProfile));
+	if (profile == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	pthread_mutex_lock(&profiles_mutex);
+	if (profiles == NULL) {
+		atexit(print_lex_profile);
+	}
+	profile->next = profiles;
+	profiles = profile;
+	if (profile_names == NULL) {
+		profile_names = names;
+	}
+	pthread_mutex_unlock(&profiles_mutex);
+
+	thread_profile = profile;
+	return profile;
+}
+
+/**
+ * @brief Starts timing the scan for the next match, if it is due to be sampled
+ */
+static void schedule_sample(LexProfile *profile) {
+	if (profile->countdown > 0) {
+		--profile->countdown;
+		profile->scan_sampled = 0;
+		return;
+	}
+	profile->countdown = LEX_PROFILE_SAMPLE_PERIOD - 1;
+	profile->scan_sampled = 1;
+	profile->scan_start = read_cycles();
+}
+
+/**
+ * @brief Ends the running action, counting the bytes it consumed but not timing it
+ */
+static void close_action(LexProfile *profile, size_t consumed) {
+	profile->rule->bytes += consumed;
+	profile->condition->bytes += consumed;
+	profile->rule = NULL;
+	profile->action_sampled = 0;
+}
+
+void profile_lex_enter(const LexProfileNames *names) {
+	LexProfile *profile = get_profile(names);
+
+	if (profile->rule != NULL) { // The last action returned from the scanner rather than ending with `break`
+		close_action(profile, profile->length);
+	}
+	schedule_sample(profile); // Time spent outside the scanner is never charged to a rule
+}
+
+void profile_lex_match(int rule, int condition, size_t length, int backed_up) {
+	uint64_t now = read_cycles();
+	LexProfile *profile = get_profile(NULL);
+	if (profile->rule != NULL) {
+		close_action(profile, profile->length);
+	}
+	if (rule < 0 || rule >= MAX_LEX_RULES || condition < 0 || condition >= MAX_LEX_CONDITIONS) {
+		return;
+	}
+
+	LexCounters *counters[] = {&profile->rules[rule], &profile->conditions[condition]};
+	for (int i = 0; i < 2; ++i) {
+		++counters[i]->matches;
+		counters[i]->backups += backed_up ? 1 : 0;
+		if (profile->scan_sampled) {
+			++counters[i]->samples;
+			counters[i]->scan_cycles += now - profile->scan_start;
+		}
+	}
+	profile->rule = counters[0];
+	profile->condition = counters[1];
+	profile->length = length;
+	profile->action_sampled = profile->scan_sampled;
+	profile->scan_sampled = 0;
+	profile->action_start = read_cycles(); // After the counting, which is not part of the action
+}
+
+void profile_lex_action_end(size_t consumed) {
+	uint64_t now = read_cycles();
+	LexProfile *profile = get_profile(NULL);
+	if (profile->rule != NULL) {
+		if (profile->action_sampled) {
+			profile->rule->action_cycles += now - profile->action_start;
+			profile->condition->action_cycles += now - profile->action_start;
+		}
+		close_action(profile, consumed);
+	}
+	schedule_sample(profile);
+}
+
+/**
+ * @brief Estimates the cycles spent on every match from those spent on the samples
+ */
+static double estimated_cycles(const LexCounters *counters) {
+	if (counters->samples == 0) {
+		return 0;
+	}
+	return (double)(counters->scan_cycles + counters->action_cycles) * counters->matches / counters->samples;
+}
+
+static int compare_counters(const void *a, const void *b) {
+	const LexCounters *first = *(const LexCounters *const *)a;
+	const LexCounters *second = *(const LexCounters *const *)b;
+	double first_cycles = estimated_cycles(first);
+	double second_cycles = estimated_cycles(second);
+	if (first_cycles != second_cycles) {
+		return (first_cycles < second_cycles) ? 1 : -1;
+	}
+	return (first->matches < second->matches) - (first->matches > second->matches);
+}
+
+static void print_counters(FILE *stream, const char *title, const LexCounters *counters, size_t count, const char *const *names, size_t name_count) {
+	const LexCounters *sorted[MAX_LEX_CONDITIONS > MAX_LEX_RULES ? MAX_LEX_CONDITIONS : MAX_LEX_RULES];
+	size_t sorted_count = 0;
+	double total_cycles = 0;
+	for (size_t i = 0; i < count; ++i) {
+		if (counters[i].matches > 0) {
+			sorted[sorted_count++] = &counters[i];
+			total_cycles += estimated_cycles(&counters[i]);
+		}
+	}
+	qsort(sorted, sorted_count, sizeof(sorted[0]), compare_counters);
+
+	fprintf(
+		stream,
+		"%-36s %12s %12s %10s %12s %10s %10s %7s\n",
+		title,
+		"matches",
+		"bytes",
+		"backups",
+		"M " CYCLE_UNIT,
+		"per match",
+		"per byte",
+		"share"
+	);
+	for (size_t i = 0; i < sorted_count; ++i) {
+		const LexCounters *entry = sorted[i];
+		size_t index = (size_t)(entry - counters);
+		double cycles = estimated_cycles(entry);
+
+		char fallback_name[32];
+		const char *name = (index < name_count && names[index] != NULL) ? names[index] : NULL;
+		if (name == NULL) {
+			snprintf(fallback_name, sizeof(fallback_name), "#%zu", index);
+			name = fallback_name;
+		}
+		fprintf(
+			stream,
+			"%-36s %12llu %12llu %10llu %12.1f %10.1f %10.2f %6.1f%%\n",
+			name,
+			(unsigned long long)entry->matches,
+			(unsigned long long)entry->bytes,
+			(unsigned long long)entry->backups,
+			cycles / 1e6,
+			cycles / entry->matches,
+			(entry->bytes > 0) ? cycles / entry->bytes : 0.0,
+			(total_cycles > 0) ? cycles * 100 / total_cycles : 0.0
+		);
+	}
+}
+
+/**
+ * @brief Writes the counts of every thread to standard error, with the rules and start conditions which
+ * took the longest first
+ */
+static void print_lex_profile() {
+	LexProfile total = {0};
+	pthread_mutex_lock(&profiles_mutex);
+	for (LexProfile *profile = profiles; profile != NULL; profile = profile->next) {
+		LexCounters *counters[] = {total.rules, total.conditions};
+		const LexCounters *added[] = {profile->rules, profile->conditions};
+		size_t counts[] = {MAX_LEX_RULES, MAX_LEX_CONDITIONS};
+		for (int kind = 0; kind < 2; ++kind) {
+			for (size_t i = 0; i < counts[kind]; ++i) {
+				counters[kind][i].matches += added[kind][i].matches;
+				counters[kind][i].bytes += added[kind][i].bytes;
+				counters[kind][i].backups += added[kind][i].backups;
+				counters[kind][i].samples += added[kind][i].samples;
+				counters[kind][i].scan_cycles += added[kind][i].scan_cycles;
+				counters[kind][i].action_cycles += added[kind][i].action_cycles;
+			}
+		}
+	}
+	const LexProfileNames *names = profile_names;
+	pthread_mutex_unlock(&profiles_mutex);
+
+	uint64_t matches = 0;
+	uint64_t backups = 0;
+	for (size_t i = 0; i < MAX_LEX_RULES; ++i) {
+		matches += total.rules[i].matches;
+		backups += total.rules[i].backups;
+	}
+	if (matches == 0 || names == NULL) {
+		fprintf(stderr, "Lexer profile: no rules matched (the flex scanner only runs when built with LEXER=flex)\n");
+		return;
+	}
+
+	fprintf(
+		stderr,
+		"Lexer profile: %llu matches, %llu of which backed up; " CYCLE_UNIT " estimated from 1 in %d matches\n\n",
+		(unsigned long long)matches,
+		(unsigned long long)backups,
+		LEX_PROFILE_SAMPLE_PERIOD
+	);
+	print_counters(stderr, "rule", total.rules, MAX_LEX_RULES, names->rules, names->rule_count);
+	fprintf(stderr, "\n");
+	print_counters(stderr, "start condition", total.conditions, MAX_LEX_CONDITIONS, names->conditions, names->condition_count);
+}
@@ -0,0 +1,55 @@
+#ifndef DOCMARK_LEX_PROFILE_H
+#define DOCMARK_LEX_PROFILE_H
+
+#include <stddef.h>
+
+/**
+ * @brief How the scanner's rules and start conditions are named in the report
+ */
+typedef struct LexProfileNames {
+	const char *const *rules; // Indexed by the number flex gives each rule, from 1 in the order they are written
+	size_t rule_count;
+	const char *const *conditions; // Indexed by start condition, from `INITIAL`
+	size_t condition_count;
+} LexProfileNames;
+
+#ifdef DOCMARK_LEX_PROFILE
+
+#define PROFILE_LEX_ENTER(names) profile_lex_enter(names)
+#define PROFILE_LEX_MATCH(rule, condition, length, backed_up) profile_lex_match(rule, condition, length, backed_up)
+#define PROFILE_LEX_ACTION_END(consumed) profile_lex_action_end(consumed)
+
+#else // Profiling compiles to nothing
+
+#define PROFILE_LEX_ENTER(names) ((void)0)
+#define PROFILE_LEX_MATCH(rule, condition, length, backed_up) ((void)0)
+#define PROFILE_LEX_ACTION_END(consumed) ((void)0)
+
+#endif
+
+/**
+ * @brief Starts profiling a call to the scanner on the calling thread; the first call schedules the report,
+ * which is written to standard error at exit with the counts of every thread
+ *
+ * @param names The names of the scanner's rules and start conditions, which must outlive the program
+ */
+void profile_lex_enter(const LexProfileNames *names);
+
+/**
+ * @brief Counts a match, before its action runs
+ *
+ * @param rule The number of the rule which matched
+ * @param condition The start condition it matched in
+ * @param length The length of the match
+ * @param backed_up Whether the scanner read past the match and had to back up to it
+ */
+void profile_lex_match(int rule, int condition, size_t length, int backed_up);
+
+/**
+ * @brief Ends the action of the last match, if it is still running
+ *
+ * @param consumed The bytes the match consumed, once its action had shortened or extended it
+ */
+void profile_lex_action_end(size_t consumed);
+
+#endif
@@ -1,5 +1,6 @@
 #include "docmark_lexer.h"
 
+#include "docmark_block_lexer.h"
 #include "docmark_token_lexers.h"
 #include "docmark_debug.h"
 
@@ -8,84 +9,112 @@
 /**
  * @brief Calls the appropriate lexer for the given token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-static int lex_token(Token *token) {
-	switch (token->type) {
+static int lex_token(DocmarkLexContext *context, TokenId token) {
+	switch (context->tree->tokens.type[token]) {
 		case ROOT:
-			return lex_root(token);
+			return lex_root(context, token);
 		case HEADING:
-			return lex_heading(token);
+			return lex_heading(context, token);
 		case ITALIC:
-			return lex_(token);
+			return lex_italic(context, token);
 		case BOLD:
-			return lex_(token);
+			return lex_bold(context, token);
 		case UNDERSCORE:
-			return lex_(token);
+			return lex_underscore(context, token);
 		case STRIKETHROUGH:
-			return lex_(token);
+			return lex_strikethrough(context, token);
 		case HIGHLIGHT:
-			return lex_(token);
+			return lex_highlight(context, token);
 		case SUPERSCRIPT:
-			return lex_(token);
+			return lex_superscript(context, token);
 		case SUBSCRIPT:
-			return lex_(token);
+			return lex_subscript(context, token);
 		case BLOCKQUOTE:
-			return lex_(token);
+			return lex_(context, token);
 		case ORDERED_LIST:
-			return lex_(token);
+			return lex_(context, token);
 		case UNORDERED_LIST:
-			return lex_(token);
+			return lex_(context, token);
 		case DESCRIPTION_LIST:
-			return lex_(token);
+			return lex_(context, token);
 		case LIST_ELEMENT:
-			return lex_list_element(token);
+			return lex_list_element(context, token);
 		case DESCRIPTION_LIST_KEY:
-			return lex_(token);
+			return lex_(context, token);
 		case DESCRIPTION_LIST_VALUE:
-			return lex_(token);
+			return lex_(context, token);
 		case LINK:
-			return lex_(token);
+			return lex_(context, token);
 		case IMAGE:
-			return lex_(token);
+			return lex_(context, token);
 		case AUDIO:
-			return lex_(token);
+			return lex_(context, token);
 		case VIDEO:
-			return lex_(token);
+			return lex_(context, token);
 		case TOP_TITLED_TABLE:
-			return lex_(token);
+			return lex_(context, token);
 		case LEFT_TITLED_TABLE:
-			return lex_(token);
+			return lex_(context, token);
 		case TWO_WAY_TABLE:
-			return lex_(token);
+			return lex_(context, token);
 		case FOOTNOTE_NOTE:
-			return lex_(token);
+			return lex_(context, token);
 		case ENDNOTE_NOTE:
-			return lex_(token);
+			return lex_(context, token);
 		case PARAGRAPH:
-			return lex_paragraph(token);
+			return lex_paragraph(context, token);
 		case INDENTED_PARAGRAPH:
-			return lex_(token);
+			return lex_(context, token);
 		default:
-			printf("WARNING: Unknown token type: %d\n", token->type);
-			print_token("", token);
-			return lex_(token);
+			TRACE(TRACE_LEX, "WARNING: Unknown token type: %d\n", context->tree->tokens.type[token]);
+			TRACE_TOKEN(TRACE_LEX, context->tree, token);
+			return lex_(context, token);
 	}
 }
 
-int lex_recursive(Token *token) {
-	if (is_raw(token)) {
-		return 0;
-	}
-	else {
-		lex_token(token);
-		if (token->num_children > 0) {
-			for (int i = 0; i < token->num_children; i++) {
-				lex_recursive(token->children[i]);
+int lex_recursive(DocmarkLexContext *context, TokenId token) {
+	// The tree is walked through its parent and sibling links rather than the C stack, so that untrusted
+	// documents cannot exhaust it; the depth is only counted to enforce the limit
+	TokenTree *tree = context->tree;
+	TokenId current = token;
+	unsigned int depth = 0;
+	for (;;) {
+		if (!is_raw(tree, current)) {
+			if (depth > tree->max_depth) {
+				return -1;
+			}
+			TRACE_TOKEN(TRACE_LEX, tree, current);
+			lex_token(context, current);
+			// The columns are looked up afresh each time, as lexing a token may reallocate them
+			if (tree->tokens.first_child[current] != NO_TOKEN) {
+				current = tree->tokens.first_child[current];
+				++depth;
+				continue;
 			}
+			mark_raw(tree, current);
+		}
+
+		// Every ancestor is lexed, so each is marked as raw once the last of its children is done
+		while (current != token && tree->tokens.next_sibling[current] == NO_TOKEN) {
+			current = tree->tokens.parent[current];
+			--depth;
+			mark_raw(tree, current);
 		}
-		mark_raw(token);
-		return 0;
+		if (current == token) {
+			return 0;
+		}
+		current = tree->tokens.next_sibling[current];
 	}
-}
\ No newline at end of file
+}
+
+int lex_document(DocmarkLexContext *context, TokenId root) {
+#ifdef DOCMARK_FLEX_LEXER
+	return lex_recursive(context, root);
+#else
+	return lex_blocks(context, root);
+#endif
+}
@@ -2,13 +2,30 @@
 #define GENERIC_LEXER_H
 
 #include "docmark_token.h"
+#include "docmark_token_lexers.h"
 
 /**
- * @brief Recursively lexes a token and its children
+ * @brief Lexes a token and, in turn, each of its descendants
  * 
+ * The tree is walked iteratively, so nesting is only bounded by the tree's
+ * `max_depth`, beyond which lexing fails.
+ * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_recursive(Token *token);
+int lex_recursive(DocmarkLexContext *context, TokenId token);
+
+/**
+ * @brief Lexes a whole document with the lexer selected at build time
+ * 
+ * The single-pass block lexer is used unless `DOCMARK_FLEX_LEXER` is defined,
+ * in which case each token is lexed in turn by the scanner.
+ * 
+ * @param context The lexing context of the document being lexed
+ * @param root The root token of the document
+ * @return int (0 on success, -1 on failure)
+ */
+int lex_document(DocmarkLexContext *context, TokenId root);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "docmark_line_classes.h"
+
+#include <ctype.h>
+
+static int is_blank(char character) {
+	return character == ' ' || character == '\t';
+}
+
+static int is_whole_line(const char *line, size_t length, const char *text) {
+	return length == 2 && line[0] == text[0] && line[1] == text[1];
+}
+
+unsigned int classify_line(const char *line, size_t length, int is_document) {
+	if (length == 0) {
+		return 0;
+	}
+
+	unsigned int classes = 0;
+	size_t i = 0;
+	switch (line[0]) {
+		case '>':
+			while (i < length && line[i] == '>') {
+				++i;
+			}
+			if (i < length && is_blank(line[i])) {
+				classes |= QUOTE_LINE;
+			}
+			break;
+		case '-':
+			if (length >= 2 && is_blank(line[1])) {
+				classes |= UNORDERED_ITEM_LINE;
+			}
+			break;
+		case ':':
+			if (length >= 2 && is_blank(line[1])) {
+				classes |= DESCRIPTION_VALUE_LINE;
+			}
+			break;
+		case ' ':
+			if (length >= 2 && line[1] == ' ') {
+				classes |= CONTINUATION_LINE;
+			}
+			break;
+		case '\t':
+			classes |= CONTINUATION_LINE;
+			break;
+		default:
+			if (isdigit((unsigned char)line[0])) {
+				while (i < length && isdigit((unsigned char)line[i])) {
+					++i;
+				}
+				if (i + 1 < length && line[i] == '.' && is_blank(line[i + 1])) {
+					classes |= ORDERED_ITEM_LINE;
+				}
+			}
+			break;
+	}
+	if (line[0] != ' ' && line[0] != '\t' && line[0] != '\r' && line[0] != '-' && line[0] != ':') {
+		classes |= DESCRIPTION_KEY_LINE;
+	}
+
+	if (!is_document) {
+		return classes;
+	}
+
+	switch (line[0]) {
+		case '-':
+			for (i = 0; i < length && line[i] == '-'; ++i);
+			if (i == length && length >= 3) {
+				classes |= HORIZONTAL_RULE_LINE;
+			}
+			break;
+		case '#':
+			for (i = 0; i < length && line[i] == '#'; ++i);
+			if (i <= 6 && i < length && is_blank(line[i])) {
+				classes |= HEADING_LINE;
+			}
+			break;
+		case '`':
+			if (length >= 2 && line[1] == '`') {
+				for (i = 2; i < length && isalnum((unsigned char)line[i]); ++i);
+				if (i == length) {
+					classes |= CODE_BLOCK_START_LINE;
+				}
+				if (length == 2) {
+					classes |= CODE_BLOCK_END_LINE;
+				}
+			}
+			break;
+		case '[':
+		case '|':
+			if (is_whole_line(line, length, "[|") || is_whole_line(line, length, "||") || is_whole_line(line, length, "|]")) {
+				classes |= COLUMN_LINE;
+			}
+			break;
+	}
+	return classes;
+}
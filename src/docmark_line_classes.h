@@ -0,0 +1,35 @@
+#ifndef DOCMARK_LINE_CLASSES_H
+#define DOCMARK_LINE_CLASSES_H
+
+#include <stddef.h>
+
+/**
+ * @brief The block rules which a line could begin or continue, as bit flags
+ */
+typedef enum LineClass {
+	QUOTE_LINE = 1 << 0, // `>+[ \t]`
+	ORDERED_ITEM_LINE = 1 << 1, // `[0-9]+\.[ \t]`
+	UNORDERED_ITEM_LINE = 1 << 2, // `-[ \t]`
+	CONTINUATION_LINE = 1 << 3, // `  ` or `\t`
+	DESCRIPTION_KEY_LINE = 1 << 4, // Anything but whitespace, `-` or `:`
+	DESCRIPTION_VALUE_LINE = 1 << 5, // `:[ \t]`
+
+	// Only classified in the document itself, as nothing else may hold these blocks
+	HORIZONTAL_RULE_LINE = 1 << 6, // `---+` and nothing else
+	HEADING_LINE = 1 << 7, // `#{1,6}[ \t]`
+	CODE_BLOCK_START_LINE = 1 << 8, // "``" and an alphanumeric language, if any
+	CODE_BLOCK_END_LINE = 1 << 9, // "``" and nothing else
+	COLUMN_LINE = 1 << 10, // `[|`, `||` or `|]` and nothing else
+} LineClass;
+
+/**
+ * @brief Classifies a line by the block rules it matches the start of
+ *
+ * @param line The line, which need not be terminated
+ * @param length The length of the line, excluding its newline
+ * @param is_document Whether the line belongs to the document itself rather than a list element
+ * @return unsigned int The LineClass flags of the line
+ */
+unsigned int classify_line(const char *line, size_t length, int is_document);
+
+#endif
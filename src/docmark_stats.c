@@ -0,0 +1,182 @@
+#include "docmark_stats.h"
+
+#include "docmark_debug.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+static const char *const phase_names[STATS_PHASE_COUNT] = {
+	[STATS_READ] = "read",
+	[STATS_LEX] = "lex",
+	[STATS_ORDER] = "order",
+	[STATS_PARSE] = "parse",
+	[STATS_WRITE] = "write",
+};
+
+DocmarkStats *create_stats() {
+	DocmarkStats *stats = (DocmarkStats *)calloc(1, sizeof(DocmarkStats));
+	if (stats == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	return stats;
+}
+
+void free_stats(DocmarkStats *stats) {
+	free(stats);
+}
+
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+void start_stats_clock(StatsClock *clock) {
+	clock_gettime(CLOCK_MONOTONIC, &clock->wall);
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &clock->cpu);
+}
+
+void record_stats_phase(DocmarkStats *stats, StatsPhase phase, StatsClock *clock) {
+	StatsClock now;
+	start_stats_clock(&now);
+	stats->wall_seconds[phase] += elapsed_seconds(&clock->wall, &now.wall);
+	stats->cpu_seconds[phase] += elapsed_seconds(&clock->cpu, &now.cpu);
+	*clock = now;
+}
+
+static size_t token_kind(TokenType type) {
+	if (type >= -BUILT_IN_FUNCTION_RETURN) {
+		return (type < 0) ? (size_t)-type : (size_t)type;
+	}
+	return LEXED_KIND_COUNT + (size_t)(type - HORIZONTAL_RULE);
+}
+
+static TokenType kind_type(size_t kind) {
+	return (kind < LEXED_KIND_COUNT) ? (TokenType)kind : (TokenType)(HORIZONTAL_RULE + (int)(kind - LEXED_KIND_COUNT));
+}
+
+void count_document_stats(
+	DocmarkStats *stats,
+	const TokenTree *tree,
+	const Arena *arena,
+	const IdentifierArray *heading_identifier_array,
+	const IdentifierArray *other_identifier_array
+) {
+	++stats->documents;
+	for (size_t i = 0; i < tree->count; ++i) {
+		++stats->tokens[token_kind(tree->tokens.type[i])];
+	}
+	stats->add_child_calls += tree->add_child_calls;
+	stats->arena_bytes += arena_allocated_bytes(arena);
+	size_t tree_bytes = token_tree_bytes(tree); // The worker's tree is reused, so it is only counted once
+	if (tree_bytes > stats->tree_bytes) {
+		stats->tree_bytes = tree_bytes;
+	}
+	stats->identifiers += heading_identifier_array->count + other_identifier_array->count;
+}
+
+void merge_stats(DocmarkStats *total, const DocmarkStats *stats) {
+	for (int phase = 0; phase < STATS_PHASE_COUNT; ++phase) {
+		total->wall_seconds[phase] += stats->wall_seconds[phase];
+		total->cpu_seconds[phase] += stats->cpu_seconds[phase];
+	}
+	for (size_t kind = 0; kind < TOKEN_KIND_COUNT; ++kind) {
+		total->tokens[kind] += stats->tokens[kind];
+	}
+	total->documents += stats->documents;
+	total->bytes_read += stats->bytes_read;
+	total->add_child_calls += stats->add_child_calls;
+	total->arena_bytes += stats->arena_bytes;
+	total->tree_bytes += stats->tree_bytes; // Every worker has a tree of its own
+	total->lex_calls += stats->lex_calls;
+	total->identifiers += stats->identifiers;
+}
+
+int parse_stats_format(const char *argument, StatsFormat *format) {
+	if (argument == NULL || strcmp(argument, "text") == 0) {
+		*format = STATS_TEXT;
+	} else if (strcmp(argument, "json") == 0) {
+		*format = STATS_JSON;
+	} else {
+		fprintf(stderr, "Error: Unknown stats format: %s\n", argument);
+		return -1;
+	}
+	return 0;
+}
+
+static void print_text(FILE *stream, const DocmarkStats *stats, double wall_seconds, double cpu_seconds, long peak_rss) {
+	fprintf(stream, "%-8s %12s %12s\n", "phase", "wall (ms)", "cpu (ms)");
+	for (int phase = 0; phase < STATS_PHASE_COUNT; ++phase) {
+		fprintf(stream, "%-8s %12.3f %12.3f\n", phase_names[phase], stats->wall_seconds[phase] * 1e3, stats->cpu_seconds[phase] * 1e3);
+	}
+	fprintf(stream, "%-8s %12.3f %12.3f\n", "run", wall_seconds * 1e3, cpu_seconds * 1e3);
+
+	fprintf(stream, "\n");
+	fprintf(stream, "%-24s %zu\n", "documents", stats->documents);
+	fprintf(stream, "%-24s %zu\n", "bytes read", stats->bytes_read);
+	fprintf(stream, "%-24s %zu\n", "add_child calls", stats->add_child_calls);
+	fprintf(stream, "%-24s %zu\n", "lex calls", stats->lex_calls);
+	fprintf(stream, "%-24s %zu\n", "identifiers", stats->identifiers);
+	fprintf(stream, "%-24s %zu\n", "arena bytes", stats->arena_bytes);
+	fprintf(stream, "%-24s %zu\n", "token bytes", stats->tree_bytes);
+	fprintf(stream, "%-24s %ld\n", "peak rss (KB)", peak_rss);
+
+	fprintf(stream, "\ntokens\n");
+	for (size_t kind = 0; kind < TOKEN_KIND_COUNT; ++kind) {
+		if (stats->tokens[kind] > 0) {
+			fprintf(stream, "  %-22s %zu\n", token_type_name(kind_type(kind)), stats->tokens[kind]);
+		}
+	}
+}
+
+static void print_json(FILE *stream, const DocmarkStats *stats, double wall_seconds, double cpu_seconds, long peak_rss) {
+	fprintf(stream, "{\n\t\"phases\": {\n");
+	for (int phase = 0; phase < STATS_PHASE_COUNT; ++phase) {
+		fprintf(
+			stream,
+			"\t\t\"%s\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f},\n",
+			phase_names[phase],
+			stats->wall_seconds[phase] * 1e3,
+			stats->cpu_seconds[phase] * 1e3
+		);
+	}
+	fprintf(stream, "\t\t\"run\": {\"wall_ms\": %.3f, \"cpu_ms\": %.3f}\n\t},\n", wall_seconds * 1e3, cpu_seconds * 1e3);
+
+	fprintf(stream, "\t\"documents\": %zu,\n", stats->documents);
+	fprintf(stream, "\t\"bytes_read\": %zu,\n", stats->bytes_read);
+	fprintf(stream, "\t\"add_child_calls\": %zu,\n", stats->add_child_calls);
+	fprintf(stream, "\t\"lex_calls\": %zu,\n", stats->lex_calls);
+	fprintf(stream, "\t\"identifiers\": %zu,\n", stats->identifiers);
+	fprintf(stream, "\t\"arena_bytes\": %zu,\n", stats->arena_bytes);
+	fprintf(stream, "\t\"token_bytes\": %zu,\n", stats->tree_bytes);
+	fprintf(stream, "\t\"peak_rss_kb\": %ld,\n", peak_rss);
+
+	fprintf(stream, "\t\"tokens\": {");
+	const char *separator = "\n";
+	for (size_t kind = 0; kind < TOKEN_KIND_COUNT; ++kind) {
+		if (stats->tokens[kind] > 0) {
+			fprintf(stream, "%s\t\t\"%s\": %zu", separator, token_type_name(kind_type(kind)), stats->tokens[kind]);
+			separator = ",\n";
+		}
+	}
+	fprintf(stream, "%s}\n}\n", (*separator == ',') ? "\n\t" : "");
+}
+
+void print_stats(FILE *stream, const DocmarkStats *stats, const StatsClock *clock, StatsFormat format) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	double wall_seconds = elapsed_seconds(&clock->wall, &now);
+
+	// The run's CPU time covers every worker, unlike the clock's, which only covers its own thread
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	double cpu_seconds =
+		usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+		usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+
+	if (format == STATS_JSON) {
+		print_json(stream, stats, wall_seconds, cpu_seconds, usage.ru_maxrss);
+	} else {
+		print_text(stream, stats, wall_seconds, cpu_seconds, usage.ru_maxrss);
+	}
+}
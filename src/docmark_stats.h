@@ -0,0 +1,120 @@
+#ifndef DOCMARK_STATS_H
+#define DOCMARK_STATS_H
+
+#include "arena.h"
+#include "docmark_token.h"
+#include "identifier_array.h"
+
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * @brief The phases of compiling a document, which are timed separately
+ */
+typedef enum StatsPhase {
+	STATS_READ,
+	STATS_LEX,
+	STATS_ORDER,
+	STATS_PARSE,
+	STATS_WRITE,
+	STATS_PHASE_COUNT,
+} StatsPhase;
+
+typedef enum StatsFormat {
+	STATS_TEXT,
+	STATS_JSON,
+} StatsFormat;
+
+// Token types are counted by kind, whether or not they have been marked as raw: first those which are
+// lexed (from RAW_DATA onwards), then those which are raw as soon as they are created
+#define LEXED_KIND_COUNT (BUILT_IN_FUNCTION_RETURN + 1)
+#define TOKEN_KIND_COUNT (LEXED_KIND_COUNT + (RIGHT_COLUMN - HORIZONTAL_RULE + 1))
+
+/**
+ * @brief Totals for every document compiled by a worker, or by the whole run once merged
+ */
+typedef struct DocmarkStats {
+	double wall_seconds[STATS_PHASE_COUNT];
+	double cpu_seconds[STATS_PHASE_COUNT];
+
+	size_t documents;
+	size_t bytes_read;
+	size_t tokens[TOKEN_KIND_COUNT];
+	size_t add_child_calls;
+	size_t arena_bytes; // Allocated from the arenas, which hold synthesized text (none unless the flex lexer is used)
+	size_t tree_bytes; // Reserved for token columns, at the largest each worker's tree grew to
+	size_t lex_calls;
+	size_t identifiers;
+} DocmarkStats;
+
+/**
+ * @brief The start of the phase being timed, in wall-clock and thread CPU time
+ */
+typedef struct StatsClock {
+	struct timespec wall;
+	struct timespec cpu;
+} StatsClock;
+
+DocmarkStats *create_stats();
+
+void free_stats(DocmarkStats *stats);
+
+void start_stats_clock(StatsClock *clock);
+
+/**
+ * @brief Adds the time since the clock was started to a phase, then restarts the clock for the next phase
+ *
+ * @param stats The totals to be added to
+ * @param phase The phase which has just ended
+ * @param clock The clock, started when the phase began
+ */
+void record_stats_phase(DocmarkStats *stats, StatsPhase phase, StatsClock *clock);
+
+/**
+ * @brief Counts a compiled document's tokens, allocations and identifiers
+ *
+ * Everything counted is read from the structures after the fact, so compiling
+ * pays nothing for it.
+ *
+ * @param stats The totals to be added to
+ * @param tree The document's token tree
+ * @param arena The arena holding the document's synthesized text
+ * @param heading_identifier_array The document's heading identifiers
+ * @param other_identifier_array The document's other identifiers
+ */
+void count_document_stats(
+	DocmarkStats *stats,
+	const TokenTree *tree,
+	const Arena *arena,
+	const IdentifierArray *heading_identifier_array,
+	const IdentifierArray *other_identifier_array
+);
+
+/**
+ * @brief Adds one set of totals to another
+ *
+ * @param total The totals to be added to
+ * @param stats The totals to be added
+ */
+void merge_stats(DocmarkStats *total, const DocmarkStats *stats);
+
+/**
+ * @brief Parses the value of `--stats`: nothing or `text` for text, or `json`
+ *
+ * @param argument The value, or NULL if none was given
+ * @param format Receives the format
+ * @return int (0 on success, -1 on failure)
+ */
+int parse_stats_format(const char *argument, StatsFormat *format);
+
+/**
+ * @brief Writes a report of the totals, along with the run's own times and peak memory
+ *
+ * @param stream The stream to be written to
+ * @param stats The totals for the whole run
+ * @param clock The clock started when the run began
+ * @param format How the report is written
+ */
+void print_stats(FILE *stream, const DocmarkStats *stats, const StatsClock *clock, StatsFormat format);
+
+#endif
@@ -1,107 +1,202 @@
 #include "docmark_token.h"
 
-#include <malloc.h>
+#include "docmark_definitions.h"
+
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 
-#define MAX_CHILDREN 10000
+#define INITIAL_TREE_CAPACITY 256
 
-Token *root_token(const char *data) {
-	Token *root = malloc(sizeof(Token));
+static void *grow_column(void *column, size_t capacity, size_t size) {
+	column = realloc(column, capacity * size);
+	if (column == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	return column;
+}
 
-	if (root == NULL) {
-		fprintf(stderr, "Error allocating memory for root token!");
-		exit(EXIT_FAILURE);
-  }
+static void grow_columns(TokenColumns *columns, size_t capacity) {
+	columns->type = grow_column(columns->type, capacity, sizeof(TokenType));
+	columns->rank = grow_column(columns->rank, capacity, sizeof(unsigned int));
+	columns->text = grow_column(columns->text, capacity, sizeof(const char *));
+	columns->data = grow_column(columns->data, capacity, sizeof(Span));
+	columns->attribute = grow_column(columns->attribute, capacity, sizeof(Span));
+	columns->parent = grow_column(columns->parent, capacity, sizeof(TokenId));
+	columns->first_child = grow_column(columns->first_child, capacity, sizeof(TokenId));
+	columns->last_child = grow_column(columns->last_child, capacity, sizeof(TokenId));
+	columns->next_sibling = grow_column(columns->next_sibling, capacity, sizeof(TokenId));
+}
 
-	root->type = ROOT;
-	root->data = strdup(data);;
-	root->attribute = NULL;
-	root->rank = 0;
-	root->parent = NULL;
-	root->children = NULL;
-	root->num_children = 0;
+static void free_columns(TokenColumns *columns) {
+	free(columns->type);
+	free(columns->rank);
+	free(columns->text);
+	free(columns->data);
+	free(columns->attribute);
+	free(columns->parent);
+	free(columns->first_child);
+	free(columns->last_child);
+	free(columns->next_sibling);
+}
+
+TokenTree *create_token_tree() {
+	TokenTree *tree = (TokenTree *)calloc(1, sizeof(TokenTree));
+	if (tree == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	tree->max_depth = DEFAULT_MAX_DEPTH;
+	return tree;
+}
 
-	return root;
+void reset_token_tree(TokenTree *tree) {
+	tree->count = 0;
+	tree->add_child_calls = 0;
 }
 
-void mark_raw(Token *token) {
-	if (token->type > 0) {
-		token->type = -token->type;
+void free_token_tree(TokenTree *tree) {
+	if (tree == NULL) {
+		return;
 	}
+
+	free_columns(&tree->tokens);
+	free_columns(&tree->spare);
+	free(tree->scratch);
+	free(tree);
 }
 
-int is_raw(Token *token) {
-	return (token->type <= 0);
+size_t token_tree_bytes(const TokenTree *tree) {
+	size_t column_bytes = sizeof(TokenType) + sizeof(unsigned int) + sizeof(const char *) + 2 * sizeof(Span) + 4 * sizeof(TokenId);
+	return tree->capacity * (2 * column_bytes + sizeof(TokenId)); // The spare columns and the scratch space grow alongside
 }
 
-void add_child(
+/**
+ * @brief Appends a token with no children, growing the columns geometrically
+ */
+static TokenId append_token(
+	TokenTree *tree,
 	const TokenType type,
-	const char* data,
-	const char* attribute,
+	const char *text,
+	const Span data,
+	const Span attribute,
 	const unsigned int rank,
-	Token *parent
+	const TokenId parent
 ) {
-	if (parent->num_children == 0) {
-		parent->children = malloc(sizeof(Token*));
-	} else if (parent->num_children >= MAX_CHILDREN) {
-		fprintf(stderr, "Error: Number of child tokens exceeded maximum (%d)!", MAX_CHILDREN);
-		exit(1);
-	} else {
-		parent->children = realloc(parent->children, (parent->num_children + 1) * sizeof(Token*));
+	if (tree->count == tree->capacity) { // Storage is kept across resets
+		if (tree->capacity >= NO_TOKEN / 2) {
+			fprintf(stderr, "Error: Number of tokens exceeded maximum (%u)!\n", NO_TOKEN);
+			exit(1);
+		}
+		size_t capacity = (tree->capacity == 0) ? INITIAL_TREE_CAPACITY : tree->capacity * 2;
+		grow_columns(&tree->tokens, capacity);
+		grow_columns(&tree->spare, capacity);
+		tree->scratch = grow_column(tree->scratch, capacity, sizeof(TokenId));
+		tree->capacity = capacity;
 	}
 
-	Token* child = malloc(sizeof(Token));
-
-	child->type = type;
-	child->rank = rank;
-	child->parent = parent;
-	child->children = NULL;
-	child->num_children = 0;
+	TokenColumns *tokens = &tree->tokens;
+	TokenId token = (TokenId)tree->count++;
+	tokens->type[token] = type;
+	tokens->rank[token] = rank;
+	tokens->text[token] = text;
+	tokens->data[token] = data;
+	tokens->attribute[token] = attribute;
+	tokens->parent[token] = parent;
+	tokens->first_child[token] = NO_TOKEN;
+	tokens->last_child[token] = NO_TOKEN;
+	tokens->next_sibling[token] = NO_TOKEN;
+	return token;
+}
 
-	if (data) {
-		child->data = strdup(data);
-	} else {
-		child->data = NULL;
+TokenId root_token(TokenTree *tree, const char *data, size_t length) {
+	if (length > UINT_MAX) { // Spans could not reach the end of it
+		return NO_TOKEN;
 	}
 
-	if (attribute) {
-		child->attribute = strdup(attribute);
-	} else {
-		child->attribute = NULL;
+	// Borrowed from the source buffer, never copied
+	return append_token(tree, ROOT, data, (Span){0, (unsigned int)length}, EMPTY_SPAN, 0, NO_TOKEN);
+}
+
+void mark_raw(TokenTree *tree, TokenId token) {
+	if (tree->tokens.type[token] > 0) {
+		tree->tokens.type[token] = -tree->tokens.type[token];
 	}
+}
 
-	parent->children[parent->num_children] = child;
-	++parent->num_children;
+int is_raw(TokenTree *tree, TokenId token) {
+	return (tree->tokens.type[token] <= 0);
 }
 
-void delete_children(Token **token) {
-	if ((*token)->children) {
-		for (unsigned int i = 0; i < (*token)->num_children; ++i) {
-			delete_token(&((*token)->children[i]));
-		}
-		free((*token)->children);
-		(*token)->children = NULL;
+TokenId add_child(
+	TokenTree *tree,
+	const TokenType type,
+	const char *text,
+	const Span data,
+	const Span attribute,
+	const unsigned int rank,
+	const TokenId parent
+) {
+	++tree->add_child_calls;
+	TokenId child = append_token(tree, type, text, data, attribute, rank, parent);
+
+	TokenColumns *tokens = &tree->tokens;
+	if (tokens->last_child[parent] != NO_TOKEN) {
+		tokens->next_sibling[tokens->last_child[parent]] = child;
+	} else {
+		tokens->first_child[parent] = child;
 	}
-	(*token)->num_children = 0;
+	tokens->last_child[parent] = child;
+	return child;
+}
+
+static TokenId renumber(const TokenId *position, TokenId token) {
+	return (token == NO_TOKEN) ? NO_TOKEN : position[token];
 }
 
-void delete_token(Token **token) {
-	if (!token || !(*token)) {
+void order_token_tree(TokenTree *tree) {
+	if (tree->count == 0) {
 		return;
 	}
 
-	if ((*token)->data) {
-		free((*token)->data);
+	TokenColumns *tokens = &tree->tokens;
+	TokenId *position = tree->scratch;
+
+	// Children are always added after their parents, so one backward pass totals the subtree sizes...
+	for (size_t i = 0; i < tree->count; ++i) {
+		position[i] = 1;
+	}
+	for (size_t i = tree->count - 1; i > 0; --i) {
+		position[tokens->parent[i]] += position[i];
 	}
 
-	if ((*token)->attribute) {
-		free((*token)->attribute);
+	// ...and one forward pass places each token's children, subtree by subtree, directly behind it
+	position[0] = 0;
+	for (size_t i = 0; i < tree->count; ++i) {
+		TokenId next = position[i] + 1;
+		for (TokenId child = tokens->first_child[i]; child != NO_TOKEN; child = tokens->next_sibling[child]) {
+			TokenId subtree_size = position[child];
+			position[child] = next;
+			next += subtree_size;
+		}
 	}
 
-	delete_children(token);
+	TokenColumns *ordered = &tree->spare;
+	for (size_t i = 0; i < tree->count; ++i) {
+		TokenId token = position[i];
+		ordered->type[token] = tokens->type[i];
+		ordered->rank[token] = tokens->rank[i];
+		ordered->text[token] = tokens->text[i];
+		ordered->data[token] = tokens->data[i];
+		ordered->attribute[token] = tokens->attribute[i];
+		ordered->parent[token] = renumber(position, tokens->parent[i]);
+		ordered->first_child[token] = renumber(position, tokens->first_child[i]);
+		ordered->last_child[token] = renumber(position, tokens->last_child[i]);
+		ordered->next_sibling[token] = renumber(position, tokens->next_sibling[i]);
+	}
 
-	free(*token);
-	*token = NULL;
-}
\ No newline at end of file
+	TokenColumns swap = tree->tokens;
+	tree->tokens = tree->spare;
+	tree->spare = swap;
+}
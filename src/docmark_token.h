@@ -1,10 +1,13 @@
 #ifndef DOCMARK_TOKEN_H
 #define DOCMARK_TOKEN_H
 
+#include <stdint.h>
 #include <stdlib.h>
 
 #define INT_16_MIN -0x8000
 
+#define TOKEN_DATA_PADDING 2 // Two NUL sentinels, so that token data can be scanned in place
+
 typedef enum TokenType {
 	HORIZONTAL_RULE = INT_16_MIN,
 	FOOTNOTE_REFERENCE,
@@ -56,33 +59,116 @@ typedef enum TokenType {
 	BUILT_IN_FUNCTION_RETURN,
 } TokenType;
 
-typedef struct Token {
-	TokenType type;
-	char* data;
-	char* attribute;
-	unsigned int rank;
+/**
+ * @brief A slice of the text a token views, so that token text need not be copied
+ */
+typedef struct Span {
+	unsigned int offset;
+	unsigned int length;
+} Span;
+
+#define EMPTY_SPAN ((Span){0, 0})
+
+typedef uint32_t TokenId;
+
+#define NO_TOKEN UINT32_MAX
+
+/**
+ * @brief The columns of a token tree, one array per field, indexed by `TokenId`
+ */
+typedef struct TokenColumns {
+	TokenType *type;
+	unsigned int *rank;
+	const char **text; // The document, or arena storage for synthesized text (NULL if the token has no data)
+	Span *data;
+	Span *attribute; // Empty if the token has no attribute
+
+	TokenId *parent;
+	TokenId *first_child;
+	TokenId *last_child; // So that children are appended in constant time
+	TokenId *next_sibling;
+} TokenColumns;
 
-	struct Token *parent;
-	struct Token **children;
-	unsigned int num_children;
-} Token;
+/**
+ * @brief A flat tree of tokens, stored as a struct of arrays
+ * 
+ * Tokens are numbered in the order they are added while lexing, and renumbered
+ * in pre-order by `order_token_tree()` before parsing, so that every subtree is
+ * a contiguous range and traversals scan the columns linearly. The root is
+ * always token 0.
+ */
+typedef struct TokenTree {
+	TokenColumns tokens;
+	TokenColumns spare; // The columns tokens are renumbered into; kept to be reused
+	TokenId *scratch; // Subtree sizes, then pre-order positions, while renumbering
+	size_t count;
+	size_t capacity;
+	size_t add_child_calls; // Since the tree was last reset
+	unsigned int max_depth; // How deeply tokens may nest below the root before lexing or parsing fails
+} TokenTree;
 
-Token *root_token(const char *data);
+TokenTree *create_token_tree();
 
-void mark_raw(Token *token);
+/**
+ * @brief Removes every token, keeping the columns for reuse
+ * 
+ * @param tree The tree to be reset
+ */
+void reset_token_tree(TokenTree *tree);
 
-int is_raw(Token *token);
+void free_token_tree(TokenTree *tree);
 
-void add_child(
+/**
+ * @brief Measures the column storage reserved for the tree's tokens, including that used while renumbering them
+ *
+ * @param tree The tree to be measured
+ * @return size_t
+ */
+size_t token_tree_bytes(const TokenTree *tree);
+
+/**
+ * @brief Adds the root token, viewing the given document, to an empty tree
+ * 
+ * Tokens only hold spans of the document, so it must outlive the tree.
+ * 
+ * @param tree The tree to which the root is added
+ * @param data The document, which must be followed by `TOKEN_DATA_PADDING` NUL sentinels
+ * @param length The length of the document, excluding the sentinels
+ * @return TokenId (`NO_TOKEN` if the document is too large to be viewed through spans)
+ */
+TokenId root_token(TokenTree *tree, const char *data, size_t length);
+
+void mark_raw(TokenTree *tree, TokenId token);
+
+int is_raw(TokenTree *tree, TokenId token);
+
+/**
+ * @brief Appends a child token viewing spans of the given text
+ * 
+ * @param tree The tree to which the child is added
+ * @param type The type of the child
+ * @param text The text which the spans index, which must outlive the tree (NULL if the child has no data)
+ * @param data The span of the child's data
+ * @param attribute The span of the child's attribute (`EMPTY_SPAN` if it has none)
+ * @param rank The rank of the child
+ * @param parent The token to which the child is added
+ * @return TokenId The new child
+ */
+TokenId add_child(
+	TokenTree *tree,
 	const TokenType type,
-	const char *data,
-	const char *attribute,
+	const char *text,
+	const Span data,
+	const Span attribute,
 	const unsigned int rank,
-	Token *parent
+	const TokenId parent
 );
 
-void delete_children(Token **token);
-
-void delete_token(Token **token);
+/**
+ * @brief Renumbers the tokens in pre-order, so that each token is followed by its subtree
+ * 
+ * @param tree The tree to be renumbered
+ */
+void order_token_tree(TokenTree *tree);
 
 #endif
\ No newline at end of file
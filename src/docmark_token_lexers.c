@@ -1,52 +1,209 @@
 #line 1 "src/docmark_token_lexers.c"
 	#include "docmark_token_lexers.h"
 
+	#include "delimiter_scan.h"
 	#include "docmark_debug.h"
 	#include "docmark_definitions.h"
+	#include "docmark_inline_lexer.h"
+	#include "docmark_lex_profile.h"
 
 	#include <stdlib.h>
 	#include <stdio.h>
 	#include <string.h>
 
-	// FLAGS
-	unsigned int heading_rank = 0;
-	int in_left_column = 0;
-	int in_right_column = 0;
-
-	Token *current_token;
-	int LAST_CONDITION = 0;
-	int buffer_counter = 0;
-	size_t buffer_size = 0;
-	char *buffer = NULL;
-
-	static void flush_buffer_raw() {
-		if (buffer) {
-			add_child(RAW_DATA, buffer, NULL, 0, current_token);
-			buffer_counter = 0;
-			buffer[buffer_counter] = '\0';
+	/**
+	 * @brief Maps text in the buffer being scanned back to a span of the current token's text
+	 */
+	static Span span_of(DocmarkLexContext *context, const char *start, size_t length) {
+		unsigned int offset = context->tree->tokens.data[context->current_token].offset + (unsigned int)(start - context->scan_base);
+		return (Span){offset, (unsigned int)length};
+	}
+
+	static TokenId add_span(DocmarkLexContext *context, TokenType type, const char *start, size_t length, TokenId parent) {
+		const char *text = context->tree->tokens.text[context->current_token];
+		return add_child(context->tree, type, text, span_of(context, start, length), EMPTY_SPAN, 0, parent);
+	}
+
+	/**
+	 * @brief Allocates zeroed storage for synthesized text, so that it keeps its sentinels and can be scanned in place
+	 */
+	static char *alloc_synthesized(DocmarkLexContext *context, size_t length) {
+		char *text = arena_alloc(context->arena, length + TOKEN_DATA_PADDING);
+		memset(text, '\0', length + TOKEN_DATA_PADDING);
+		return text;
+	}
+
+	static void extend_run(DocmarkLexContext *context, const char *text, size_t length) {
+		if (context->run_length == 0) {
+			context->run_start = text;
+		}
+		context->run_length += length; // Every other rule flushes the run or only matches at the start of a line
+	}
+
+	/**
+	 * @brief Extends the current match over the plain text which follows it, so that plain text costs one
+	 * action per run rather than one per character; `find_end` must stop at every character where
+	 * another rule could begin a match, so that scanning resumes exactly where it otherwise would
+	 */
+	#define MATCH_PLAIN_TEXT(find_end) \
+		do { \
+			*yy_cp = yyg->yy_hold_char; /* Expose the character hidden by the terminator of yytext */ \
+			yyless(yyleng + find_end(yy_cp, yyextra->scan_end - yy_cp)); \
+		} while (0)
+
+	/**
+	 * @brief Extends the current match to the end of its line and lexes it with the shared inline lexer, which
+	 * runs in linear time where the greedy inline rules would rescan the line from every delimiter; the plain
+	 * text which ends the line extends the run
+	 */
+	#define MATCH_INLINE_LINE() \
+		do { \
+			*yy_cp = yyg->yy_hold_char; /* Expose the character hidden by the terminator of yytext */ \
+			yyless(find_line_end(yytext, yyextra->scan_end - yytext)); \
+			lex_inline_rest(yyextra, yytext, yyleng); \
+		} while (0)
+
+	#ifdef DOCMARK_LEX_PROFILE
+	/**
+	 * @brief Counts every match before its action runs, and ends its timing at the `break` which follows the
+	 * action; a match backed up if the scanner resumed from the last accepting state it passed
+	 */
+	#define YY_USER_ACTION \
+		PROFILE_LEX_MATCH( \
+			yy_act, \
+			YY_START, \
+			yyleng, \
+			yy_cp == yyg->yy_last_accepting_cpos && yy_current_state == yyg->yy_last_accepting_state \
+		);
+	#define YY_BREAK \
+		PROFILE_LEX_ACTION_END(yyg->yy_c_buf_p - yy_bp); \
+		break;
+
+	// Named in the order the rules are written, which is how flex numbers them (from 1, after a placeholder)
+	static const char *const rule_names[] = {
+		NULL,
+		"RAW_DATA .",
+		"RAW_DATA \\n",
+		"HORIZONTAL_RULE",
+		"heading start",
+		"HEADING with identifier",
+		"HEADING",
+		"ITALIC (one character)",
+		"ITALIC",
+		"BOLD (one character)",
+		"BOLD",
+		"UNDERSCORE (one character)",
+		"UNDERSCORE",
+		"STRIKETHROUGH (one character)",
+		"STRIKETHROUGH",
+		"HIGHLIGHT (one character)",
+		"HIGHLIGHT",
+		"SUPERSCRIPT (one character)",
+		"SUPERSCRIPT",
+		"SUBSCRIPT (one character)",
+		"SUBSCRIPT",
+		"BLOCKQUOTE",
+		"ORDERED_LIST",
+		"UNORDERED_LIST",
+		"DESCRIPTION_LIST",
+		"INLINE_CODE (one character)",
+		"INLINE_CODE",
+		"CODE_BLOCK start",
+		"CODE_BLOCK end",
+		"CODE_BLOCK line",
+		"CODE_BLOCK blank line",
+		"CODE_BLOCK \\n",
+		"LEFT_COLUMN",
+		"DIVIDER_COLUMN",
+		"RIGHT_COLUMN",
+		"PARAGRAPH .",
+		"PARAGRAPH \\n",
+		"unhandled .",
+		"unhandled \\n",
+		"jammed (default rule)",
+	};
+
+	// Named in the order the start conditions are declared, after `INITIAL`
+	static const char *const condition_names[] = {
+		"INITIAL",
+		"LEX_ROOT",
+		"LEX_HEADING",
+		"LEX_ITALIC",
+		"LEX_BOLD",
+		"LEX_UNDERSCORE",
+		"LEX_STRIKETHROUGH",
+		"LEX_HIGHLIGHT",
+		"LEX_SUPERSCRIPT",
+		"LEX_SUBSCRIPT",
+		"LEX_BLOCKQUOTE",
+		"LEX_LIST_ELEMENT",
+		"LEX_DESCRIPTION_LIST_KEY",
+		"LEX_DESCRIPTION_LIST_VALUE",
+		"LEX_LINK",
+		"LEX_IMAGE",
+		"LEX_AUDIO",
+		"LEX_VIDEO",
+		"LEX_TOP_TITLED_TABLE",
+		"LEX_LEFT_TITLED_TABLE",
+		"LEX_TWO_WAY_TABLE",
+		"LEX_INFOBOX_TITLE",
+		"LEX_INFOBOX_CONTENT",
+		"LEX_FOOTNOTE_NOTE",
+		"LEX_ENDNOTE_NOTE",
+		"LEX_PARAGRAPH",
+		"LEX_INDENTED_PARAGRAPH",
+		"IN_RAW",
+		"IN_HEADING",
+		"IN_ITALIC",
+		"IN_BLOCKQUOTE",
+		"IN_CODE_BLOCK",
+		"IN_PARAGRAPH",
+	};
+
+	static const LexProfileNames lex_profile_names = {
+		rule_names,
+		sizeof(rule_names) / sizeof(rule_names[0]),
+		condition_names,
+		sizeof(condition_names) / sizeof(condition_names[0]),
+	};
+	#endif
+
+	static void flush_run_raw(DocmarkLexContext *context) {
+		if (context->run_length > 0) {
+			add_span(context, RAW_DATA, context->run_start, context->run_length, context->current_token);
+			context->run_length = 0;
 		}
 	}
 	
-	static void flush_buffer_paragraph() {
-		char* buffer_pointer = buffer;
-		if (buffer) {
-			if (strlen(buffer_pointer) > 1) {
-				if (*buffer_pointer == ' ' || *buffer_pointer == '\t') {
-					while(*buffer_pointer == ' ' || *buffer_pointer == '\t') {
-						++buffer_pointer;
-					}
-					add_child(INDENTED_PARAGRAPH, buffer_pointer, NULL, 0, current_token);
-				}
-				else {
-					add_child(PARAGRAPH, buffer, NULL, 0, current_token);
+	static void flush_run_paragraph(DocmarkLexContext *context) {
+		const char *run_pointer = context->run_start;
+		size_t run_length = context->run_length;
+		if (run_length > 1) {
+			if (*run_pointer == ' ' || *run_pointer == '\t') {
+				while (run_length > 0 && (*run_pointer == ' ' || *run_pointer == '\t')) {
+					++run_pointer;
+					--run_length;
 				}
+				add_span(context, INDENTED_PARAGRAPH, run_pointer, run_length, context->current_token);
+			}
+			else {
+				add_span(context, PARAGRAPH, run_pointer, run_length, context->current_token);
 			}
-			buffer_counter = 0;
-			buffer[buffer_counter] = '\0';
 		}
+		context->run_length = 0;
 	}
 
-#line 49 "src/docmark_token_lexers.c"
+	static void lex_inline_rest(DocmarkLexContext *context, const char *line, size_t length) {
+		const char *text = context->tree->tokens.text[context->current_token];
+		flush_run_raw(context);
+		++context->lex_calls;
+		size_t run_start = lex_inline_line(context->tree, text, text + span_of(context, line, 0).offset, length, context->current_token);
+		if (run_start < length) {
+			extend_run(context, line + run_start, length - run_start);
+		}
+	}
+
+#line 206 "src/docmark_token_lexers.c"
 
 #define  YY_INT_ALIGNED short int
 
@@ -157,21 +314,38 @@ typedef unsigned int flex_uint32_t;
  */
 #define YY_SC_TO_UI(c) ((YY_CHAR) (c))
 
+/* An opaque pointer. */
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void* yyscan_t;
+#endif
+
+/* For convenience, these vars (plus the bison vars far below)
+   are macros in the reentrant scanner. */
+#define yyin yyg->yyin_r
+#define yyout yyg->yyout_r
+#define yyextra yyg->yyextra_r
+#define yyleng yyg->yyleng_r
+#define yytext yyg->yytext_r
+#define yylineno (YY_CURRENT_BUFFER_LVALUE->yy_bs_lineno)
+#define yycolumn (YY_CURRENT_BUFFER_LVALUE->yy_bs_column)
+#define yy_flex_debug yyg->yy_flex_debug_r
+
 /* Enter a start condition.  This macro really ought to take a parameter,
  * but we do it the disgusting crufty way forced on us by the ()-less
  * definition of BEGIN.
  */
-#define BEGIN (yy_start) = 1 + 2 *
+#define BEGIN yyg->yy_start = 1 + 2 *
 /* Translate the current start state into a value that can be later handed
  * to BEGIN to return to the state.  The YYSTATE alias is for lex
  * compatibility.
  */
-#define YY_START (((yy_start) - 1) / 2)
+#define YY_START ((yyg->yy_start - 1) / 2)
 #define YYSTATE YY_START
 /* Action number for EOF rule of a given start state. */
 #define YY_STATE_EOF(state) (YY_END_OF_BUFFER + state + 1)
 /* Special action meaning "start processing a new file". */
-#define YY_NEW_FILE yyrestart( yyin  )
+#define YY_NEW_FILE yyrestart( yyin , yyscanner )
 #define YY_END_OF_BUFFER_CHAR 0
 
 /* Size of default input buffer. */
@@ -201,10 +375,6 @@ typedef struct yy_buffer_state *YY_BUFFER_STATE;
 typedef size_t yy_size_t;
 #endif
 
-extern int yyleng;
-
-extern FILE *yyin, *yyout;
-
 #define EOB_ACT_CONTINUE_SCAN 0
 #define EOB_ACT_END_OF_FILE 1
 #define EOB_ACT_LAST_MATCH 2
@@ -219,13 +389,13 @@ extern FILE *yyin, *yyout;
 		/* Undo effects of setting up yytext. */ \
         int yyless_macro_arg = (n); \
         YY_LESS_LINENO(yyless_macro_arg);\
-		*yy_cp = (yy_hold_char); \
+		*yy_cp = yyg->yy_hold_char; \
 		YY_RESTORE_YY_MORE_OFFSET \
-		(yy_c_buf_p) = yy_cp = yy_bp + yyless_macro_arg - YY_MORE_ADJ; \
+		yyg->yy_c_buf_p = yy_cp = yy_bp + yyless_macro_arg - YY_MORE_ADJ; \
 		YY_DO_BEFORE_ACTION; /* set up yytext again */ \
 		} \
 	while ( 0 )
-#define unput(c) yyunput( c, (yytext_ptr)  )
+#define unput(c) yyunput( c, yyg->yytext_ptr , yyscanner )
 
 #ifndef YY_STRUCT_YY_BUFFER_STATE
 #define YY_STRUCT_YY_BUFFER_STATE
@@ -292,77 +462,57 @@ struct yy_buffer_state
 	};
 #endif /* !YY_STRUCT_YY_BUFFER_STATE */
 
-/* Stack of input buffers. */
-static size_t yy_buffer_stack_top = 0; /**< index of top of stack. */
-static size_t yy_buffer_stack_max = 0; /**< capacity of stack. */
-static YY_BUFFER_STATE * yy_buffer_stack = NULL; /**< Stack as an array. */
-
 /* We provide macros for accessing buffer states in case in the
  * future we want to put the buffer states in a more general
  * "scanner state".
  *
  * Returns the top of the stack, or NULL.
  */
-#define YY_CURRENT_BUFFER ( (yy_buffer_stack) \
-                          ? (yy_buffer_stack)[(yy_buffer_stack_top)] \
+#define YY_CURRENT_BUFFER ( yyg->yy_buffer_stack \
+                          ? yyg->yy_buffer_stack[yyg->yy_buffer_stack_top] \
                           : NULL)
 /* Same as previous macro, but useful when we know that the buffer stack is not
  * NULL or when we need an lvalue. For internal use only.
  */
-#define YY_CURRENT_BUFFER_LVALUE (yy_buffer_stack)[(yy_buffer_stack_top)]
-
-/* yy_hold_char holds the character lost when yytext is formed. */
-static char yy_hold_char;
-static int yy_n_chars;		/* number of characters read into yy_ch_buf */
-int yyleng;
-
-/* Points to current character in buffer. */
-static char *yy_c_buf_p = NULL;
-static int yy_init = 0;		/* whether we need to initialize */
-static int yy_start = 0;	/* start state number */
-
-/* Flag which is used to allow yywrap()'s to do buffer switches
- * instead of setting up a fresh yyin.  A bit of a hack ...
- */
-static int yy_did_buffer_switch_on_eof;
+#define YY_CURRENT_BUFFER_LVALUE yyg->yy_buffer_stack[yyg->yy_buffer_stack_top]
 
-void yyrestart ( FILE *input_file  );
-void yy_switch_to_buffer ( YY_BUFFER_STATE new_buffer  );
-YY_BUFFER_STATE yy_create_buffer ( FILE *file, int size  );
-void yy_delete_buffer ( YY_BUFFER_STATE b  );
-void yy_flush_buffer ( YY_BUFFER_STATE b  );
-void yypush_buffer_state ( YY_BUFFER_STATE new_buffer  );
-void yypop_buffer_state ( void );
+void yyrestart ( FILE *input_file , yyscan_t yyscanner);
+void yy_switch_to_buffer ( YY_BUFFER_STATE new_buffer , yyscan_t yyscanner);
+YY_BUFFER_STATE yy_create_buffer ( FILE *file, int size , yyscan_t yyscanner);
+void yy_delete_buffer ( YY_BUFFER_STATE b , yyscan_t yyscanner);
+void yy_flush_buffer ( YY_BUFFER_STATE b , yyscan_t yyscanner);
+void yypush_buffer_state ( YY_BUFFER_STATE new_buffer , yyscan_t yyscanner);
+void yypop_buffer_state (yyscan_t yyscanner);
 
-static void yyensure_buffer_stack ( void );
-static void yy_load_buffer_state ( void );
-static void yy_init_buffer ( YY_BUFFER_STATE b, FILE *file  );
-#define YY_FLUSH_BUFFER yy_flush_buffer( YY_CURRENT_BUFFER )
+static void yyensure_buffer_stack (yyscan_t yyscanner);
+static void yy_load_buffer_state (yyscan_t yyscanner);
+static void yy_init_buffer ( YY_BUFFER_STATE b, FILE *file , yyscan_t yyscanner);
+#define YY_FLUSH_BUFFER yy_flush_buffer( YY_CURRENT_BUFFER , yyscanner)
 
-YY_BUFFER_STATE yy_scan_buffer ( char *base, yy_size_t size  );
-YY_BUFFER_STATE yy_scan_string ( const char *yy_str  );
-YY_BUFFER_STATE yy_scan_bytes ( const char *bytes, int len  );
+YY_BUFFER_STATE yy_scan_buffer ( char *base, yy_size_t size , yyscan_t yyscanner);
+YY_BUFFER_STATE yy_scan_string ( const char *yy_str , yyscan_t yyscanner);
+YY_BUFFER_STATE yy_scan_bytes ( const char *bytes, int len , yyscan_t yyscanner);
 
-void *yyalloc ( yy_size_t  );
-void *yyrealloc ( void *, yy_size_t  );
-void yyfree ( void *  );
+void *yyalloc ( yy_size_t , yyscan_t yyscanner);
+void *yyrealloc ( void *, yy_size_t , yyscan_t yyscanner);
+void yyfree ( void * , yyscan_t yyscanner);
 
 #define yy_new_buffer yy_create_buffer
 #define yy_set_interactive(is_interactive) \
 	{ \
 	if ( ! YY_CURRENT_BUFFER ){ \
-        yyensure_buffer_stack (); \
+        yyensure_buffer_stack( yyscanner ); \
 		YY_CURRENT_BUFFER_LVALUE =    \
-            yy_create_buffer( yyin, YY_BUF_SIZE ); \
+            yy_create_buffer( yyin, YY_BUF_SIZE , yyscanner ); \
 	} \
 	YY_CURRENT_BUFFER_LVALUE->yy_is_interactive = is_interactive; \
 	}
 #define yy_set_bol(at_bol) \
 	{ \
 	if ( ! YY_CURRENT_BUFFER ){\
-        yyensure_buffer_stack (); \
+        yyensure_buffer_stack( yyscanner ); \
 		YY_CURRENT_BUFFER_LVALUE =    \
-            yy_create_buffer( yyin, YY_BUF_SIZE ); \
+            yy_create_buffer( yyin, YY_BUF_SIZE , yyscanner ); \
 	} \
 	YY_CURRENT_BUFFER_LVALUE->yy_at_bol = at_bol; \
 	}
@@ -370,37 +520,28 @@ void yyfree ( void *  );
 
 /* Begin user sect3 */
 
-#define yywrap() (/*CONSTCOND*/1)
+#define yywrap(yyscanner) (/*CONSTCOND*/1)
 #define YY_SKIP_YYWRAP
 typedef flex_uint8_t YY_CHAR;
 
-FILE *yyin = NULL, *yyout = NULL;
-
 typedef int yy_state_type;
 
-extern int yylineno;
-int yylineno = 1;
-
-extern char *yytext;
-#ifdef yytext_ptr
-#undef yytext_ptr
-#endif
-#define yytext_ptr yytext
+#define yytext_ptr yytext_r
 
-static yy_state_type yy_get_previous_state ( void );
-static yy_state_type yy_try_NUL_trans ( yy_state_type current_state  );
-static int yy_get_next_buffer ( void );
-static void yynoreturn yy_fatal_error ( const char* msg  );
+static yy_state_type yy_get_previous_state (yyscan_t yyscanner);
+static yy_state_type yy_try_NUL_trans ( yy_state_type current_state , yyscan_t yyscanner);
+static int yy_get_next_buffer (yyscan_t yyscanner);
+static void yynoreturn yy_fatal_error ( const char* msg , yyscan_t yyscanner);
 
 /* Done after the current pattern has been matched and before the
  * corresponding action - sets up yytext.
  */
 #define YY_DO_BEFORE_ACTION \
-	(yytext_ptr) = yy_bp; \
+	yyg->yytext_ptr = yy_bp; \
 	yyleng = (int) (yy_cp - yy_bp); \
-	(yy_hold_char) = *yy_cp; \
+	yyg->yy_hold_char = *yy_cp; \
 	*yy_cp = '\0'; \
-	(yy_c_buf_p) = yy_cp;
+	yyg->yy_c_buf_p = yy_cp;
 #define YY_NUM_RULES 39
 #define YY_END_OF_BUFFER 40
 /* This struct is not used in this scanner,
@@ -904,12 +1045,6 @@ static const flex_int16_t yy_chk[1498] =
 
     } ;
 
-static yy_state_type yy_last_accepting_state;
-static char *yy_last_accepting_cpos;
-
-extern int yy_flex_debug;
-int yy_flex_debug = 0;
-
 /* The intent behind this definition is that it'll catch
  * any uses of REJECT which flex missed.
  */
@@ -917,7 +1052,6 @@ int yy_flex_debug = 0;
 #define yymore() yymore_used_but_not_detected
 #define YY_MORE_ADJ 0
 #define YY_RESTORE_YY_MORE_OFFSET
-char *yytext;
 #line 1 "src/docmark_token_lexers.l"
 
 
@@ -952,7 +1086,7 @@ char *yytext;
 
 
 
-#line 955 "src/docmark_token_lexers.c"
+#line 1089 "src/docmark_token_lexers.c"
 
 #define INITIAL 0
 #define LEX_ROOT 1
@@ -996,40 +1130,80 @@ char *yytext;
 #include <unistd.h>
 #endif
 
-#ifndef YY_EXTRA_TYPE
-#define YY_EXTRA_TYPE void *
-#endif
+#define YY_EXTRA_TYPE DocmarkLexContext *
+
+/* Holds the entire state of the reentrant scanner. */
+struct yyguts_t
+    {
+
+    /* User-defined. Not touched by flex. */
+    YY_EXTRA_TYPE yyextra_r;
+
+    /* The rest are the same as the globals declared in the non-reentrant scanner. */
+    FILE *yyin_r, *yyout_r;
+    size_t yy_buffer_stack_top; /**< index of top of stack. */
+    size_t yy_buffer_stack_max; /**< capacity of stack. */
+    YY_BUFFER_STATE * yy_buffer_stack; /**< Stack as an array. */
+    char yy_hold_char;
+    int yy_n_chars;
+    int yyleng_r;
+    char *yy_c_buf_p;
+    int yy_init;
+    int yy_start;
+    int yy_did_buffer_switch_on_eof;
+    int yy_start_stack_ptr;
+    int yy_start_stack_depth;
+    int *yy_start_stack;
+    yy_state_type yy_last_accepting_state;
+    char* yy_last_accepting_cpos;
+
+    int yylineno_r;
+    int yy_flex_debug_r;
 
-static int yy_init_globals ( void );
+    char *yytext_r;
+    int yy_more_flag;
+    int yy_more_len;
+
+    }; /* end struct yyguts_t */
+
+static int yy_init_globals ( yyscan_t yyscanner );
+
+int yylex_init (yyscan_t* scanner);
+
+int yylex_init_extra ( YY_EXTRA_TYPE user_defined, yyscan_t* scanner);
 
 /* Accessor methods to globals.
    These are made visible to non-reentrant scanners for convenience. */
 
-int yylex_destroy ( void );
+int yylex_destroy ( yyscan_t yyscanner );
+
+int yyget_debug (yyscan_t yyscanner);
 
-int yyget_debug ( void );
+void yyset_debug ( int debug_flag , yyscan_t yyscanner);
 
-void yyset_debug ( int debug_flag  );
+YY_EXTRA_TYPE yyget_extra (yyscan_t yyscanner);
 
-YY_EXTRA_TYPE yyget_extra ( void );
+void yyset_extra ( YY_EXTRA_TYPE user_defined , yyscan_t yyscanner);
 
-void yyset_extra ( YY_EXTRA_TYPE user_defined  );
+FILE *yyget_in (yyscan_t yyscanner);
 
-FILE *yyget_in ( void );
+void yyset_in  ( FILE * _in_str , yyscan_t yyscanner);
 
-void yyset_in  ( FILE * _in_str  );
+FILE *yyget_out (yyscan_t yyscanner);
 
-FILE *yyget_out ( void );
+void yyset_out  ( FILE * _out_str , yyscan_t yyscanner);
 
-void yyset_out  ( FILE * _out_str  );
+			int yyget_leng (yyscan_t yyscanner);
 
-			int yyget_leng ( void );
+char *yyget_text (yyscan_t yyscanner);
 
-char *yyget_text ( void );
+int yyget_lineno (yyscan_t yyscanner);
 
-int yyget_lineno ( void );
+void yyset_lineno ( int _line_number , yyscan_t yyscanner );
 
-void yyset_lineno ( int _line_number  );
+int yyget_column  ( yyscan_t yyscanner );
+
+void yyset_column ( int _column_no , yyscan_t yyscanner );
 
 /* Macros after this point can all be overridden by user definitions in
  * section 1.
@@ -1037,15 +1211,15 @@ void yyset_lineno ( int _line_number  );
 
 #ifndef YY_SKIP_YYWRAP
 #ifdef __cplusplus
-extern "C" int yywrap ( void );
+extern "C" int yywrap (yyscan_t yyscanner);
 #else
-extern int yywrap ( void );
+extern int yywrap (yyscan_t yyscanner);
 #endif
 #endif
 
 #ifndef YY_NO_UNPUT
     
-    static void yyunput ( int c, char *buf_ptr  );
+    static void yyunput ( int c, char *buf_ptr , yyscan_t yyscanner);
     
 #endif
 
@@ -1059,9 +1233,9 @@ static int yy_flex_strlen ( const char * );
 
 #ifndef YY_NO_INPUT
 #ifdef __cplusplus
-static int yyinput ( void );
+static int yyinput (yyscan_t yyscanner);
 #else
-static int input ( void );
+static int input (yyscan_t yyscanner);
 #endif
 
 #endif
@@ -1135,7 +1309,7 @@ static int input ( void );
 
 /* Report a fatal error. */
 #ifndef YY_FATAL_ERROR
-#define YY_FATAL_ERROR(msg) yy_fatal_error( msg )
+#define YY_FATAL_ERROR(msg) yy_fatal_error( msg , yyscanner)
 #endif
 
 /* end tables serialization structures and prototypes */
@@ -1146,9 +1320,9 @@ static int input ( void );
 #ifndef YY_DECL
 #define YY_DECL_IS_OURS 1
 
-extern int yylex (void);
+extern int yylex (yyscan_t yyscanner);
 
-#define YY_DECL int yylex (void)
+#define YY_DECL int yylex (yyscan_t yyscanner)
 #endif /* !YY_DECL */
 
 /* Code executed at the beginning of each rule, after yytext and yyleng
@@ -1176,17 +1350,18 @@ YY_DECL
 	yy_state_type yy_current_state;
 	char *yy_cp, *yy_bp;
 	int yy_act;
-    
-	if ( !(yy_init) )
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
+	if ( !yyg->yy_init )
 		{
-		(yy_init) = 1;
+		yyg->yy_init = 1;
 
 #ifdef YY_USER_INIT
 		YY_USER_INIT;
 #endif
 
-		if ( ! (yy_start) )
-			(yy_start) = 1;	/* first start state */
+		if ( ! yyg->yy_start )
+			yyg->yy_start = 1;	/* first start state */
 
 		if ( ! yyin )
 			yyin = stdin;
@@ -1195,32 +1370,32 @@ YY_DECL
 			yyout = stdout;
 
 		if ( ! YY_CURRENT_BUFFER ) {
-			yyensure_buffer_stack ();
+			yyensure_buffer_stack( yyscanner );
 			YY_CURRENT_BUFFER_LVALUE =
-				yy_create_buffer( yyin, YY_BUF_SIZE );
+				yy_create_buffer( yyin, YY_BUF_SIZE , yyscanner );
 		}
 
-		yy_load_buffer_state(  );
+		yy_load_buffer_state( yyscanner );
 		}
 
 	{
-#line 87 "src/docmark_token_lexers.l"
+#line 246 "src/docmark_token_lexers.l"
 
-#line 1209 "src/docmark_token_lexers.c"
+#line 1384 "src/docmark_token_lexers.c"
 
 	while ( /*CONSTCOND*/1 )		/* loops until end-of-file is reached */
 		{
-		yy_cp = (yy_c_buf_p);
+		yy_cp = yyg->yy_c_buf_p;
 
 		/* Support of yytext. */
-		*yy_cp = (yy_hold_char);
+		*yy_cp = yyg->yy_hold_char;
 
 		/* yy_bp points to the position in yy_ch_buf of the start of
 		 * the current run.
 		 */
 		yy_bp = yy_cp;
 
-		yy_current_state = (yy_start);
+		yy_current_state = yyg->yy_start;
 		yy_current_state += YY_AT_BOL();
 yy_match:
 		do
@@ -1228,8 +1403,8 @@ yy_match:
 			YY_CHAR yy_c = yy_ec[YY_SC_TO_UI(*yy_cp)] ;
 			if ( yy_accept[yy_current_state] )
 				{
-				(yy_last_accepting_state) = yy_current_state;
-				(yy_last_accepting_cpos) = yy_cp;
+				yyg->yy_last_accepting_state = yy_current_state;
+				yyg->yy_last_accepting_cpos = yy_cp;
 				}
 			while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 				{
@@ -1246,8 +1421,8 @@ yy_find_action:
 		yy_act = yy_accept[yy_current_state];
 		if ( yy_act == 0 )
 			{ /* have to back up */
-			yy_cp = (yy_last_accepting_cpos);
-			yy_current_state = (yy_last_accepting_state);
+			yy_cp = yyg->yy_last_accepting_cpos;
+			yy_current_state = yyg->yy_last_accepting_state;
 			yy_act = yy_accept[yy_current_state];
 			}
 
@@ -1259,79 +1434,70 @@ do_action:	/* This label is used only to access EOF actions. */
 	{ /* beginning of action switch */
 			case 0: /* must back up */
 			/* undo the effects of YY_DO_BEFORE_ACTION */
-			*yy_cp = (yy_hold_char);
-			yy_cp = (yy_last_accepting_cpos);
-			yy_current_state = (yy_last_accepting_state);
+			*yy_cp = yyg->yy_hold_char;
+			yy_cp = yyg->yy_last_accepting_cpos;
+			yy_current_state = yyg->yy_last_accepting_state;
 			goto yy_find_action;
 
 case 1:
 YY_RULE_SETUP
-#line 88 "src/docmark_token_lexers.l"
+#line 247 "src/docmark_token_lexers.l"
 { // RAW_DATA
-	if (buffer_counter + 1 >= buffer_size) { // Check if buffer needs to be resized
-		buffer_size = (buffer_size == 0) ? 1 : buffer_size * 2; // Double the buffer size
-		buffer = realloc(buffer, buffer_size);
-	}
-	if (buffer == NULL) {
-		fprintf(stderr, "ERROR: Memory allocation failed\n");
-		exit(1);
-	}
-
-	buffer[buffer_counter++] = *yytext;
-	buffer[buffer_counter] = '\0';
+	MATCH_PLAIN_TEXT(find_inline_delimiter);
+	extend_run(yyextra, yytext, yyleng);
 }
 	YY_BREAK
 case YY_STATE_EOF(LEX_HEADING):
 case YY_STATE_EOF(LEX_PARAGRAPH):
-#line 102 "src/docmark_token_lexers.l"
+#line 252 "src/docmark_token_lexers.l"
 { // RAW_DATA
-	flush_buffer_raw();
+	flush_run_raw(yyextra);
 	return 0;
 }
 	YY_BREAK
 case 2:
 /* rule 2 can match eol */
 YY_RULE_SETUP
-#line 107 "src/docmark_token_lexers.l"
+#line 257 "src/docmark_token_lexers.l"
 { // RAW_DATA
-	flush_buffer_raw();
+	flush_run_raw(yyextra);
 }
 	YY_BREAK
 case 3:
-*yy_cp = (yy_hold_char); /* undo effects of setting up yytext */
-(yy_c_buf_p) = yy_cp -= 1;
+*yy_cp = yyg->yy_hold_char; /* undo effects of setting up yytext */
+yyg->yy_c_buf_p = yy_cp -= 1;
 YY_DO_BEFORE_ACTION; /* set up yytext again */
 YY_RULE_SETUP
-#line 111 "src/docmark_token_lexers.l"
+#line 261 "src/docmark_token_lexers.l"
 { // HORIZONTAL_RULE
-	add_child(HORIZONTAL_RULE, NULL, NULL, 0, current_token);
+	add_child(yyextra->tree, HORIZONTAL_RULE, NULL, EMPTY_SPAN, EMPTY_SPAN, 0, yyextra->current_token);
 }
 	YY_BREAK
 case 4:
 YY_RULE_SETUP
-#line 115 "src/docmark_token_lexers.l"
+#line 265 "src/docmark_token_lexers.l"
 { // Start Heading
 	unsigned int rank = 0;
 	while (*yytext == '#') {
 		++rank;
 		++yytext;
 	}
-	heading_rank = rank;
+	yyextra->heading_rank = rank;
 
-	LAST_CONDITION = YY_START;
+	yyextra->last_condition = YY_START;
 	BEGIN(IN_HEADING);
 }
 	YY_BREAK
 case 5:
-*yy_cp = (yy_hold_char); /* undo effects of setting up yytext */
-(yy_c_buf_p) = yy_cp -= 1;
+*yy_cp = yyg->yy_hold_char; /* undo effects of setting up yytext */
+yyg->yy_c_buf_p = yy_cp -= 1;
 YY_DO_BEFORE_ACTION; /* set up yytext again */
 YY_RULE_SETUP
-#line 127 "src/docmark_token_lexers.l"
+#line 277 "src/docmark_token_lexers.l"
 { // HEADING with specified identifier
-	char *identifier = strrchr(yytext, '{') + 1;
-	char *identifier_end = identifier;
-	char *data_end = identifier - 2;
+	const char *identifier = strrchr(yytext, '{') + 1;
+	const char *identifier_end = identifier;
+	const char *data_end = identifier - 2;
 
 	while (*identifier == ' ' || *identifier == '\t') {
 		++identifier;
@@ -1345,213 +1511,150 @@ YY_RULE_SETUP
 		--data_end;
 	}
 
-	*(++data_end) = '\0';
-	*(identifier_end) = '\0';
+	++data_end;
 
-	add_child(HEADING, strdup(yytext), strdup(identifier), heading_rank, current_token);
+	add_child(
+		yyextra->tree,
+		HEADING,
+		yyextra->tree->tokens.text[yyextra->current_token],
+		span_of(yyextra, yytext, data_end - yytext),
+		span_of(yyextra, identifier, identifier_end - identifier),
+		yyextra->heading_rank,
+		yyextra->current_token
+	);
 
-	BEGIN(LAST_CONDITION);
+	BEGIN(yyextra->last_condition);
 }
 	YY_BREAK
 case 6:
-*yy_cp = (yy_hold_char); /* undo effects of setting up yytext */
-(yy_c_buf_p) = yy_cp -= 1;
+*yy_cp = yyg->yy_hold_char; /* undo effects of setting up yytext */
+yyg->yy_c_buf_p = yy_cp -= 1;
 YY_DO_BEFORE_ACTION; /* set up yytext again */
 YY_RULE_SETUP
-#line 152 "src/docmark_token_lexers.l"
+#line 309 "src/docmark_token_lexers.l"
 { // HEADING
-	int len = strlen(yytext); // Strip trailing spaces from yytext
+	int len = yyleng; // Strip trailing spaces from yytext
 	while (len > 0 && (yytext[len - 1] == ' ' || yytext[len - 1] == '\t')) {
-		yytext[len - 1] = '\0';
 		len--;
 	}
 
-	add_child(HEADING, yytext, NULL, heading_rank, current_token);
+	add_child(
+		yyextra->tree,
+		HEADING,
+		yyextra->tree->tokens.text[yyextra->current_token],
+		span_of(yyextra, yytext, len),
+		EMPTY_SPAN,
+		yyextra->heading_rank,
+		yyextra->current_token
+	);
 
-	BEGIN(LAST_CONDITION);
+	BEGIN(yyextra->last_condition);
 }
 	YY_BREAK
 case 7:
 YY_RULE_SETUP
-#line 164 "src/docmark_token_lexers.l"
+#line 328 "src/docmark_token_lexers.l"
 { // Single character ITALIC
-	flush_buffer_raw();
-	yytext += 2;
-	*yytext = '\0';
-	--yytext;
-	add_child(ITALIC, yytext, NULL, 0, current_token);
+	MATCH_INLINE_LINE(); // Lexes the rest of the line too, so that the greedy patterns match at most once per line
 }
 	YY_BREAK
 case 8:
 YY_RULE_SETUP
-#line 172 "src/docmark_token_lexers.l"
+#line 332 "src/docmark_token_lexers.l"
 { // ITALIC
-	flush_buffer_raw();
-	char *data_pointer = yytext + 1;
-	while (*data_pointer != '*') {
-		++data_pointer;
-	}
-	*data_pointer = '\0';
-	yyless(data_pointer - yytext + 1);
-	add_child(ITALIC, yytext + 1, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 9:
 YY_RULE_SETUP
-#line 183 "src/docmark_token_lexers.l"
+#line 336 "src/docmark_token_lexers.l"
 { // Single character BOLD
-	flush_buffer_raw();
-	yytext += 2;
-	*yytext = '\0';
-	--yytext;
-	add_child(BOLD, yytext, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 10:
 YY_RULE_SETUP
-#line 191 "src/docmark_token_lexers.l"
+#line 340 "src/docmark_token_lexers.l"
 { // BOLD
-	flush_buffer_raw();
-	char *data_pointer = yytext + 1;
-	while (*data_pointer != '+') {
-		++data_pointer;
-	}
-	*data_pointer = '\0';
-	yyless(data_pointer - yytext + 1);
-	add_child(BOLD, yytext + 1, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 11:
 YY_RULE_SETUP
-#line 202 "src/docmark_token_lexers.l"
+#line 344 "src/docmark_token_lexers.l"
 { // Single character UNDERSCORE
-	flush_buffer_raw();
-	yytext += 2;
-	*yytext = '\0';
-	--yytext;
-	add_child(UNDERSCORE, yytext, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 12:
 YY_RULE_SETUP
-#line 210 "src/docmark_token_lexers.l"
+#line 348 "src/docmark_token_lexers.l"
 { // UNDERSCORE
-	flush_buffer_raw();
-	char *data_pointer = yytext + 1;
-	while (*data_pointer != '~') {
-		++data_pointer;
-	}
-	*data_pointer = '\0';
-	yyless(data_pointer - yytext + 1);
-	add_child(UNDERSCORE, yytext + 1, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 13:
 YY_RULE_SETUP
-#line 221 "src/docmark_token_lexers.l"
+#line 352 "src/docmark_token_lexers.l"
 { // Single character STRIKETHROUGH
-	flush_buffer_raw();
-	yytext += 2;
-	*yytext = '\0';
-	--yytext;
-	add_child(STRIKETHROUGH, yytext, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 14:
 YY_RULE_SETUP
-#line 229 "src/docmark_token_lexers.l"
+#line 356 "src/docmark_token_lexers.l"
 { // STRIKETHROUGH
-	flush_buffer_raw();
-	char *data_pointer = yytext + 1;
-	while (*data_pointer != '-') {
-		++data_pointer;
-	}
-	*data_pointer = '\0';
-	yyless(data_pointer - yytext + 1);
-	add_child(STRIKETHROUGH, yytext + 1, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 15:
 YY_RULE_SETUP
-#line 240 "src/docmark_token_lexers.l"
+#line 360 "src/docmark_token_lexers.l"
 { // Single character HIGHLIGHT
-	flush_buffer_raw();
-	yytext += 2;
-	*yytext = '\0';
-	--yytext;
-	add_child(HIGHLIGHT, yytext, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 16:
 YY_RULE_SETUP
-#line 248 "src/docmark_token_lexers.l"
+#line 364 "src/docmark_token_lexers.l"
 { // HIGHLIGHT
-	flush_buffer_raw();
-	char *data_pointer = yytext + 1;
-	while (*data_pointer != '=') {
-		++data_pointer;
-	}
-	*data_pointer = '\0';
-	yyless(data_pointer - yytext + 1);
-	add_child(HIGHLIGHT, yytext + 1, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 17:
 YY_RULE_SETUP
-#line 259 "src/docmark_token_lexers.l"
+#line 368 "src/docmark_token_lexers.l"
 { // Single character SUPERSCRIPT
-	flush_buffer_raw();
-	yytext += 2;
-	*yytext = '\0';
-	--yytext;
-	add_child(SUPERSCRIPT, yytext, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 18:
 YY_RULE_SETUP
-#line 267 "src/docmark_token_lexers.l"
+#line 372 "src/docmark_token_lexers.l"
 { // SUPERSCRIPT
-	flush_buffer_raw();
-	char *data_pointer = yytext + 1;
-	while (*data_pointer != '^') {
-		++data_pointer;
-	}
-	*data_pointer = '\0';
-	yyless(data_pointer - yytext + 1);
-	add_child(SUPERSCRIPT, yytext + 1, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 19:
 YY_RULE_SETUP
-#line 278 "src/docmark_token_lexers.l"
+#line 376 "src/docmark_token_lexers.l"
 { // Single character SUBSCRIPT
-	flush_buffer_raw();
-	yytext += 2;
-	*yytext = '\0';
-	--yytext;
-	add_child(SUBSCRIPT, yytext, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 20:
 YY_RULE_SETUP
-#line 286 "src/docmark_token_lexers.l"
+#line 380 "src/docmark_token_lexers.l"
 { // SUBSCRIPT
-	flush_buffer_raw();
-	char *data_pointer = yytext + 1;
-	while (*data_pointer != '_') {
-		++data_pointer;
-	}
-	*data_pointer = '\0';
-	yyless(data_pointer - yytext + 1);
-	add_child(SUBSCRIPT, yytext + 1, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 21:
 /* rule 21 can match eol */
 YY_RULE_SETUP
-#line 297 "src/docmark_token_lexers.l"
+#line 384 "src/docmark_token_lexers.l"
 { // BLOCKQUOTE
-	char *stripped_data = (char *) malloc((strlen(yytext) + 1) * sizeof(char));
+	char *stripped_data = alloc_synthesized(yyextra, yyleng); // Stripping only ever shortens the text
 	char *stripped_data_counter = stripped_data;
 
 	while (*yytext == '>') {
@@ -1570,27 +1673,31 @@ YY_RULE_SETUP
 	}
 	*(--stripped_data_counter) = '\0'; // Discard trailing newline
 
-	add_child(BLOCKQUOTE, stripped_data, NULL, 0, current_token);
-	free(stripped_data);
+	Span data = {0, (unsigned int)(stripped_data_counter - stripped_data)};
+	add_child(yyextra->tree, BLOCKQUOTE, stripped_data, data, EMPTY_SPAN, 0, yyextra->current_token);
 }
 	YY_BREAK
 case 22:
 /* rule 22 can match eol */
 YY_RULE_SETUP
-#line 321 "src/docmark_token_lexers.l"
+#line 408 "src/docmark_token_lexers.l"
 { // ORDERED_LIST		/* WARNING: Must change `{2,}` to `{TAB_SIZE,}` MANUALLY! */
-	add_child(ORDERED_LIST, NULL, NULL, 0, current_token);
-	Token *working_token = current_token->children[current_token->num_children - 1];
+	TokenId working_token = add_child(yyextra->tree, ORDERED_LIST, NULL, EMPTY_SPAN, EMPTY_SPAN, 0, yyextra->current_token);
 
-	char *stripped_data = (char *) malloc((strlen(yytext) + 1) * sizeof(char));
+	// The elements are laid out one after another, each followed by its sentinels; every element sheds
+	// its signifier and trailing newline, so the stripped elements never outgrow the matched text
+	char *stripped_data = alloc_synthesized(yyextra, yyleng);
 	char *stripped_data_counter = stripped_data;
+	char *element = stripped_data;
 
 	for (;;) {
 		if (*yytext >= '0' && *yytext <= '9') {
-			if (stripped_data_counter != stripped_data) { // Create token from last set of data
+			if (stripped_data_counter != element) { // Create token from last set of data
 				*(--stripped_data_counter) = '\0'; // Discard trailing newline
-				add_child(LIST_ELEMENT, stripped_data, NULL, 0, working_token);
-				stripped_data_counter = stripped_data;
+				Span data = {(unsigned int)(element - stripped_data), (unsigned int)(stripped_data_counter - element)};
+				add_child(yyextra->tree, LIST_ELEMENT, stripped_data, data, EMPTY_SPAN, 0, working_token);
+				stripped_data_counter += TOKEN_DATA_PADDING;
+				element = stripped_data_counter;
 			}
 			while (*yytext >= '0' && *yytext <= '9') {
 				++yytext; // Consume the numerical signifier
@@ -1631,8 +1738,8 @@ YY_RULE_SETUP
 		}
 		else { // Create token from final set of data
 			*(--stripped_data_counter) = '\0'; // Discard trailing newline
-			stripped_data_counter = stripped_data;
-			add_child(LIST_ELEMENT, stripped_data, NULL, 0, working_token);
+			Span data = {(unsigned int)(element - stripped_data), (unsigned int)(stripped_data_counter - element)};
+			add_child(yyextra->tree, LIST_ELEMENT, stripped_data, data, EMPTY_SPAN, 0, working_token);
 			break;
 		}
 	}
@@ -1641,20 +1748,24 @@ YY_RULE_SETUP
 case 23:
 /* rule 23 can match eol */
 YY_RULE_SETUP
-#line 381 "src/docmark_token_lexers.l"
+#line 472 "src/docmark_token_lexers.l"
 { // UNORDERED_LIST		/* WARNING: Must change `{2,}` to `{TAB_SIZE,}` ! MANUALLY ! */
-	add_child(UNORDERED_LIST, NULL, NULL, 0, current_token);
-	Token *working_token = current_token->children[current_token->num_children - 1];
+	TokenId working_token = add_child(yyextra->tree, UNORDERED_LIST, NULL, EMPTY_SPAN, EMPTY_SPAN, 0, yyextra->current_token);
 
-	char *stripped_data = (char *) malloc((strlen(yytext) + 1) * sizeof(char));
+	// The elements are laid out one after another, each followed by its sentinels; every element sheds
+	// its signifier and trailing newline, so the stripped elements never outgrow the matched text
+	char *stripped_data = alloc_synthesized(yyextra, yyleng);
 	char *stripped_data_counter = stripped_data;
+	char *element = stripped_data;
 
 	for (;;) {
 		if (*yytext == '-') {
-			if (stripped_data_counter != stripped_data) { // Create token from last set of data
+			if (stripped_data_counter != element) { // Create token from last set of data
 				*(--stripped_data_counter) = '\0'; // Discard trailing newline
-				add_child(LIST_ELEMENT, stripped_data, NULL, 0, working_token);
-				stripped_data_counter = stripped_data;
+				Span data = {(unsigned int)(element - stripped_data), (unsigned int)(stripped_data_counter - element)};
+				add_child(yyextra->tree, LIST_ELEMENT, stripped_data, data, EMPTY_SPAN, 0, working_token);
+				stripped_data_counter += TOKEN_DATA_PADDING;
+				element = stripped_data_counter;
 			}
 			++yytext; // Consume the signifying dash
 			while (*yytext == ' ' || *yytext == '\t') {
@@ -1692,8 +1803,8 @@ YY_RULE_SETUP
 		}
 		else { // Create token from final set of data
 			*(--stripped_data_counter) = '\0'; // Discard trailing newline
-			stripped_data_counter = stripped_data;
-			add_child(LIST_ELEMENT, stripped_data, NULL, 0, working_token);
+			Span data = {(unsigned int)(element - stripped_data), (unsigned int)(stripped_data_counter - element)};
+			add_child(yyextra->tree, LIST_ELEMENT, stripped_data, data, EMPTY_SPAN, 0, working_token);
 			break;
 		}
 	}
@@ -1702,10 +1813,9 @@ YY_RULE_SETUP
 case 24:
 /* rule 24 can match eol */
 YY_RULE_SETUP
-#line 438 "src/docmark_token_lexers.l"
+#line 533 "src/docmark_token_lexers.l"
 { // DESCRIPTION_LIST
-	add_child(DESCRIPTION_LIST, NULL, NULL, 0, current_token);
-	Token *working_token = current_token->children[current_token->num_children - 1];
+	TokenId working_token = add_child(yyextra->tree, DESCRIPTION_LIST, NULL, EMPTY_SPAN, EMPTY_SPAN, 0, yyextra->current_token);
 
 	while (*yytext != '\0') {
 		if (*yytext == ':') {
@@ -1717,8 +1827,7 @@ YY_RULE_SETUP
 			while (*data_pointer != '\n') {
 				++data_pointer;
 			}
-			*data_pointer = '\0';
-			add_child(DESCRIPTION_LIST_VALUE, yytext, NULL, 0, working_token);
+			add_span(yyextra, DESCRIPTION_LIST_VALUE, yytext, data_pointer - yytext, working_token);
 			yytext = ++data_pointer;
 		}
 		else {
@@ -1726,8 +1835,7 @@ YY_RULE_SETUP
 			while (*data_pointer != '\n') {
 				++data_pointer;
 			}
-			*data_pointer = '\0';
-			add_child(DESCRIPTION_LIST_KEY, yytext, NULL, 0, working_token);
+			add_span(yyextra, DESCRIPTION_LIST_KEY, yytext, data_pointer - yytext, working_token);
 			yytext = ++data_pointer;
 		}
 	}
@@ -1735,79 +1843,63 @@ YY_RULE_SETUP
 	YY_BREAK
 case 25:
 YY_RULE_SETUP
-#line 468 "src/docmark_token_lexers.l"
+#line 560 "src/docmark_token_lexers.l"
 { // Single character INLINE_CODE
-	flush_buffer_raw();
-	yytext += 2;
-	*yytext = '\0';
-	--yytext;
-	add_child(INLINE_CODE, yytext, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 26:
 YY_RULE_SETUP
-#line 476 "src/docmark_token_lexers.l"
+#line 564 "src/docmark_token_lexers.l"
 { // INLINE_CODE
-	flush_buffer_raw();
-	char *data_pointer = yytext + 1;
-	while (*data_pointer != '`') {
-		++data_pointer;
-	}
-	*data_pointer = '\0';
-	yyless(data_pointer - yytext + 1);
-	add_child(INLINE_CODE, yytext + 1, NULL, 0, current_token);
+	MATCH_INLINE_LINE();
 }
 	YY_BREAK
 case 27:
-*yy_cp = (yy_hold_char); /* undo effects of setting up yytext */
-(yy_c_buf_p) = yy_cp -= 1;
+*yy_cp = yyg->yy_hold_char; /* undo effects of setting up yytext */
+yyg->yy_c_buf_p = yy_cp -= 1;
 YY_DO_BEFORE_ACTION; /* set up yytext again */
 YY_RULE_SETUP
-#line 488 "src/docmark_token_lexers.l"
+#line 569 "src/docmark_token_lexers.l"
 { // Start CODE_BLOCK
-	yytext += 2;
-	add_child(START_CODE_BLOCK, yytext, NULL, 0, current_token);
+	add_span(yyextra, START_CODE_BLOCK, yytext + 2, yyleng - 2, yyextra->current_token);
 	BEGIN(IN_CODE_BLOCK);
 }
 	YY_BREAK
 case 28:
-*yy_cp = (yy_hold_char); /* undo effects of setting up yytext */
-(yy_c_buf_p) = yy_cp -= 1;
+*yy_cp = yyg->yy_hold_char; /* undo effects of setting up yytext */
+yyg->yy_c_buf_p = yy_cp -= 1;
 YY_DO_BEFORE_ACTION; /* set up yytext again */
 YY_RULE_SETUP
-#line 494 "src/docmark_token_lexers.l"
+#line 574 "src/docmark_token_lexers.l"
 { // End CODE_BLOCK
-	add_child(END_CODE_BLOCK, NULL, NULL, 0, current_token);
+	add_child(yyextra->tree, END_CODE_BLOCK, NULL, EMPTY_SPAN, EMPTY_SPAN, 0, yyextra->current_token);
 	BEGIN(LEX_ROOT);
 }
 	YY_BREAK
 case 29:
-*yy_cp = (yy_hold_char); /* undo effects of setting up yytext */
-(yy_c_buf_p) = yy_cp -= 1;
+*yy_cp = yyg->yy_hold_char; /* undo effects of setting up yytext */
+yyg->yy_c_buf_p = yy_cp -= 1;
 YY_DO_BEFORE_ACTION; /* set up yytext again */
 YY_RULE_SETUP
-#line 499 "src/docmark_token_lexers.l"
+#line 579 "src/docmark_token_lexers.l"
 {
-	char *data = malloc(strlen(yytext) + 2);
-	strcpy(data, yytext);
-	strcat(data, "\n");
-	add_child(RAW_DATA, data, NULL, 0, current_token);
-	free(data);
+	add_span(yyextra, RAW_DATA, yytext, yyleng + 1, yyextra->current_token); // Including the newline which follows the line
 }
 	YY_BREAK
 case 30:
 /* rule 30 can match eol */
 YY_RULE_SETUP
-#line 507 "src/docmark_token_lexers.l"
+#line 583 "src/docmark_token_lexers.l"
 {
 	yyless(1);
-	add_child(RAW_DATA, "\n", NULL, 0, current_token);
+	add_span(yyextra, RAW_DATA, yytext, 1, yyextra->current_token);
 }
 	YY_BREAK
 case 31:
 /* rule 31 can match eol */
 YY_RULE_SETUP
-#line 512 "src/docmark_token_lexers.l"
+#line 588 "src/docmark_token_lexers.l"
 {}
 	YY_BREAK
 // TOP_TITLED_TABLE
@@ -1817,49 +1909,49 @@ YY_RULE_SETUP
 // TWO_WAY_TABLE
 
 case 32:
-*yy_cp = (yy_hold_char); /* undo effects of setting up yytext */
-(yy_c_buf_p) = yy_cp -= 1;
+*yy_cp = yyg->yy_hold_char; /* undo effects of setting up yytext */
+yyg->yy_c_buf_p = yy_cp -= 1;
 YY_DO_BEFORE_ACTION; /* set up yytext again */
 YY_RULE_SETUP
-#line 523 "src/docmark_token_lexers.l"
+#line 599 "src/docmark_token_lexers.l"
 { // LEFT_COLUMN
-	if (in_left_column || in_right_column) {
-		add_child(PARAGRAPH, yytext, NULL, 0, current_token);
+	if (yyextra->in_left_column || yyextra->in_right_column) {
+		add_span(yyextra, PARAGRAPH, yytext, yyleng, yyextra->current_token);
 	} else {
-		add_child(LEFT_COLUMN, NULL, NULL, 0, current_token);
+		add_child(yyextra->tree, LEFT_COLUMN, NULL, EMPTY_SPAN, EMPTY_SPAN, 0, yyextra->current_token);
 	}
-	in_left_column = 1;
+	yyextra->in_left_column = 1;
 }
 	YY_BREAK
 case 33:
-*yy_cp = (yy_hold_char); /* undo effects of setting up yytext */
-(yy_c_buf_p) = yy_cp -= 1;
+*yy_cp = yyg->yy_hold_char; /* undo effects of setting up yytext */
+yyg->yy_c_buf_p = yy_cp -= 1;
 YY_DO_BEFORE_ACTION; /* set up yytext again */
 YY_RULE_SETUP
-#line 532 "src/docmark_token_lexers.l"
+#line 608 "src/docmark_token_lexers.l"
 { // DIVIDER_COLUMN
-	if (!in_left_column || in_right_column) {
-		add_child(PARAGRAPH, yytext, NULL, 0, current_token);
+	if (!yyextra->in_left_column || yyextra->in_right_column) {
+		add_span(yyextra, PARAGRAPH, yytext, yyleng, yyextra->current_token);
 	} else {
-		add_child(DIVIDER_COLUMN, NULL, NULL, 0, current_token);
+		add_child(yyextra->tree, DIVIDER_COLUMN, NULL, EMPTY_SPAN, EMPTY_SPAN, 0, yyextra->current_token);
 	}
-	in_left_column = 0;
-	in_right_column = 1;
+	yyextra->in_left_column = 0;
+	yyextra->in_right_column = 1;
 }
 	YY_BREAK
 case 34:
-*yy_cp = (yy_hold_char); /* undo effects of setting up yytext */
-(yy_c_buf_p) = yy_cp -= 1;
+*yy_cp = yyg->yy_hold_char; /* undo effects of setting up yytext */
+yyg->yy_c_buf_p = yy_cp -= 1;
 YY_DO_BEFORE_ACTION; /* set up yytext again */
 YY_RULE_SETUP
-#line 542 "src/docmark_token_lexers.l"
+#line 618 "src/docmark_token_lexers.l"
 { // RIGHT_COLUMN
-	if (in_left_column || !in_right_column) {
-		add_child(PARAGRAPH, yytext, NULL, 0, current_token);
+	if (yyextra->in_left_column || !yyextra->in_right_column) {
+		add_span(yyextra, PARAGRAPH, yytext, yyleng, yyextra->current_token);
 	} else {
-		add_child(RIGHT_COLUMN, NULL, NULL, 0, current_token);
+		add_child(yyextra->tree, RIGHT_COLUMN, NULL, EMPTY_SPAN, EMPTY_SPAN, 0, yyextra->current_token);
 	}
-	in_right_column = 0;
+	yyextra->in_right_column = 0;
 }
 	YY_BREAK
 // INFOBOX_TITLE
@@ -1872,58 +1964,53 @@ YY_RULE_SETUP
 
 case 35:
 YY_RULE_SETUP
-#line 563 "src/docmark_token_lexers.l"
+#line 639 "src/docmark_token_lexers.l"
 { // PARAGRAPH
-	if (buffer_counter + 1 >= buffer_size) { // Check if buffer needs to be resized
-		buffer_size = (buffer_size == 0) ? 1 : buffer_size * 2; // Double the buffer size
-		buffer = realloc(buffer, buffer_size);
-	}
-	if (buffer == NULL) {
-		fprintf(stderr, "ERROR: Memory allocation failed\n");
-		exit(1);
+	if (YY_START == LEX_ROOT) {
+		MATCH_PLAIN_TEXT(find_line_end); // Every other rule of the root matches only at the start of a line
+		extend_run(yyextra, yytext, yyleng);
+	} else {
+		MATCH_INLINE_LINE();
 	}
-
-	buffer[buffer_counter++] = *yytext;
-	buffer[buffer_counter] = '\0';
 }
 	YY_BREAK
 case YY_STATE_EOF(LEX_ROOT):
 case YY_STATE_EOF(LEX_LIST_ELEMENT):
-#line 577 "src/docmark_token_lexers.l"
+#line 648 "src/docmark_token_lexers.l"
 { // PARAGRAPH
-	flush_buffer_paragraph();
+	flush_run_paragraph(yyextra);
 	return 0;
 }
 	YY_BREAK
 case 36:
 /* rule 36 can match eol */
 YY_RULE_SETUP
-#line 582 "src/docmark_token_lexers.l"
+#line 653 "src/docmark_token_lexers.l"
 { // PARAGRAPH
-	flush_buffer_paragraph();
+	flush_run_paragraph(yyextra);
 }
 	YY_BREAK
 case 37:
 YY_RULE_SETUP
-#line 587 "src/docmark_token_lexers.l"
+#line 658 "src/docmark_token_lexers.l"
 {
-	printf("UNHANDLED: %c\n", *yytext);
+	TRACE(TRACE_LEX, "UNHANDLED: %c\n", *yytext);
 }
 	YY_BREAK
 case 38:
 /* rule 38 can match eol */
 YY_RULE_SETUP
-#line 591 "src/docmark_token_lexers.l"
+#line 662 "src/docmark_token_lexers.l"
 {
-	printf("UNHANDLED: %c", *yytext);
+	TRACE(TRACE_LEX, "UNHANDLED: %c", *yytext);
 }
 	YY_BREAK
 case 39:
 YY_RULE_SETUP
-#line 594 "src/docmark_token_lexers.l"
+#line 665 "src/docmark_token_lexers.l"
 YY_FATAL_ERROR( "flex scanner jammed" );
 	YY_BREAK
-#line 1926 "src/docmark_token_lexers.c"
+#line 2013 "src/docmark_token_lexers.c"
 case YY_STATE_EOF(INITIAL):
 case YY_STATE_EOF(LEX_ITALIC):
 case YY_STATE_EOF(LEX_BOLD):
@@ -1958,10 +2045,10 @@ case YY_STATE_EOF(IN_PARAGRAPH):
 	case YY_END_OF_BUFFER:
 		{
 		/* Amount of text matched not including the EOB char. */
-		int yy_amount_of_matched_text = (int) (yy_cp - (yytext_ptr)) - 1;
+		int yy_amount_of_matched_text = (int) (yy_cp - yyg->yytext_ptr) - 1;
 
 		/* Undo the effects of YY_DO_BEFORE_ACTION. */
-		*yy_cp = (yy_hold_char);
+		*yy_cp = yyg->yy_hold_char;
 		YY_RESTORE_YY_MORE_OFFSET
 
 		if ( YY_CURRENT_BUFFER_LVALUE->yy_buffer_status == YY_BUFFER_NEW )
@@ -1975,7 +2062,7 @@ case YY_STATE_EOF(IN_PARAGRAPH):
 			 * this is the first action (other than possibly a
 			 * back-up) that will match for the new input source.
 			 */
-			(yy_n_chars) = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
+			yyg->yy_n_chars = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
 			YY_CURRENT_BUFFER_LVALUE->yy_input_file = yyin;
 			YY_CURRENT_BUFFER_LVALUE->yy_buffer_status = YY_BUFFER_NORMAL;
 			}
@@ -1987,13 +2074,13 @@ case YY_STATE_EOF(IN_PARAGRAPH):
 		 * end-of-buffer state).  Contrast this with the test
 		 * in input().
 		 */
-		if ( (yy_c_buf_p) <= &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)] )
+		if ( yyg->yy_c_buf_p <= &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars] )
 			{ /* This was really a NUL. */
 			yy_state_type yy_next_state;
 
-			(yy_c_buf_p) = (yytext_ptr) + yy_amount_of_matched_text;
+			yyg->yy_c_buf_p = yyg->yytext_ptr + yy_amount_of_matched_text;
 
-			yy_current_state = yy_get_previous_state(  );
+			yy_current_state = yy_get_previous_state( yyscanner );
 
 			/* Okay, we're now positioned to make the NUL
 			 * transition.  We couldn't have
@@ -2004,32 +2091,32 @@ case YY_STATE_EOF(IN_PARAGRAPH):
 			 * will run more slowly).
 			 */
 
-			yy_next_state = yy_try_NUL_trans( yy_current_state );
+			yy_next_state = yy_try_NUL_trans( yy_current_state , yyscanner );
 
-			yy_bp = (yytext_ptr) + YY_MORE_ADJ;
+			yy_bp = yyg->yytext_ptr + YY_MORE_ADJ;
 
 			if ( yy_next_state )
 				{
 				/* Consume the NUL. */
-				yy_cp = ++(yy_c_buf_p);
+				yy_cp = ++yyg->yy_c_buf_p;
 				yy_current_state = yy_next_state;
 				goto yy_match;
 				}
 
 			else
 				{
-				yy_cp = (yy_c_buf_p);
+				yy_cp = yyg->yy_c_buf_p;
 				goto yy_find_action;
 				}
 			}
 
-		else switch ( yy_get_next_buffer(  ) )
+		else switch ( yy_get_next_buffer( yyscanner ) )
 			{
 			case EOB_ACT_END_OF_FILE:
 				{
-				(yy_did_buffer_switch_on_eof) = 0;
+				yyg->yy_did_buffer_switch_on_eof = 0;
 
-				if ( yywrap(  ) )
+				if ( yywrap( yyscanner ) )
 					{
 					/* Note: because we've taken care in
 					 * yy_get_next_buffer() to have set up
@@ -2040,7 +2127,7 @@ case YY_STATE_EOF(IN_PARAGRAPH):
 					 * YY_NULL, it'll still work - another
 					 * YY_NULL will get returned.
 					 */
-					(yy_c_buf_p) = (yytext_ptr) + YY_MORE_ADJ;
+					yyg->yy_c_buf_p = yyg->yytext_ptr + YY_MORE_ADJ;
 
 					yy_act = YY_STATE_EOF(YY_START);
 					goto do_action;
@@ -2048,30 +2135,30 @@ case YY_STATE_EOF(IN_PARAGRAPH):
 
 				else
 					{
-					if ( ! (yy_did_buffer_switch_on_eof) )
+					if ( ! yyg->yy_did_buffer_switch_on_eof )
 						YY_NEW_FILE;
 					}
 				break;
 				}
 
 			case EOB_ACT_CONTINUE_SCAN:
-				(yy_c_buf_p) =
-					(yytext_ptr) + yy_amount_of_matched_text;
+				yyg->yy_c_buf_p =
+					yyg->yytext_ptr + yy_amount_of_matched_text;
 
-				yy_current_state = yy_get_previous_state(  );
+				yy_current_state = yy_get_previous_state( yyscanner );
 
-				yy_cp = (yy_c_buf_p);
-				yy_bp = (yytext_ptr) + YY_MORE_ADJ;
+				yy_cp = yyg->yy_c_buf_p;
+				yy_bp = yyg->yytext_ptr + YY_MORE_ADJ;
 				goto yy_match;
 
 			case EOB_ACT_LAST_MATCH:
-				(yy_c_buf_p) =
-				&YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)];
+				yyg->yy_c_buf_p =
+				&YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars];
 
-				yy_current_state = yy_get_previous_state(  );
+				yy_current_state = yy_get_previous_state( yyscanner );
 
-				yy_cp = (yy_c_buf_p);
-				yy_bp = (yytext_ptr) + YY_MORE_ADJ;
+				yy_cp = yyg->yy_c_buf_p;
+				yy_bp = yyg->yytext_ptr + YY_MORE_ADJ;
 				goto yy_find_action;
 			}
 		break;
@@ -2092,20 +2179,21 @@ case YY_STATE_EOF(IN_PARAGRAPH):
  *	EOB_ACT_CONTINUE_SCAN - continue scanning from current position
  *	EOB_ACT_END_OF_FILE - end of file
  */
-static int yy_get_next_buffer (void)
+static int yy_get_next_buffer (yyscan_t yyscanner)
 {
-    	char *dest = YY_CURRENT_BUFFER_LVALUE->yy_ch_buf;
-	char *source = (yytext_ptr);
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	char *dest = YY_CURRENT_BUFFER_LVALUE->yy_ch_buf;
+	char *source = yyg->yytext_ptr;
 	int number_to_move, i;
 	int ret_val;
 
-	if ( (yy_c_buf_p) > &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars) + 1] )
+	if ( yyg->yy_c_buf_p > &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars + 1] )
 		YY_FATAL_ERROR(
 		"fatal flex scanner internal error--end of buffer missed" );
 
 	if ( YY_CURRENT_BUFFER_LVALUE->yy_fill_buffer == 0 )
 		{ /* Don't try to fill the buffer, so this is an EOF. */
-		if ( (yy_c_buf_p) - (yytext_ptr) - YY_MORE_ADJ == 1 )
+		if ( yyg->yy_c_buf_p - yyg->yytext_ptr - YY_MORE_ADJ == 1 )
 			{
 			/* We matched a single character, the EOB, so
 			 * treat this as a final EOF.
@@ -2125,7 +2213,7 @@ static int yy_get_next_buffer (void)
 	/* Try to read more data. */
 
 	/* First move last chars to start of buffer. */
-	number_to_move = (int) ((yy_c_buf_p) - (yytext_ptr) - 1);
+	number_to_move = (int) (yyg->yy_c_buf_p - yyg->yytext_ptr - 1);
 
 	for ( i = 0; i < number_to_move; ++i )
 		*(dest++) = *(source++);
@@ -2134,7 +2222,7 @@ static int yy_get_next_buffer (void)
 		/* don't do the read, it's not guaranteed to return an EOF,
 		 * just force an EOF
 		 */
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars) = 0;
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars = 0;
 
 	else
 		{
@@ -2148,7 +2236,7 @@ static int yy_get_next_buffer (void)
 			YY_BUFFER_STATE b = YY_CURRENT_BUFFER_LVALUE;
 
 			int yy_c_buf_p_offset =
-				(int) ((yy_c_buf_p) - b->yy_ch_buf);
+				(int) (yyg->yy_c_buf_p - b->yy_ch_buf);
 
 			if ( b->yy_is_our_buffer )
 				{
@@ -2162,7 +2250,7 @@ static int yy_get_next_buffer (void)
 				b->yy_ch_buf = (char *)
 					/* Include room in for 2 EOB chars. */
 					yyrealloc( (void *) b->yy_ch_buf,
-							 (yy_size_t) (b->yy_buf_size + 2)  );
+							 (yy_size_t) (b->yy_buf_size + 2) , yyscanner );
 				}
 			else
 				/* Can't grow it, we don't own it. */
@@ -2172,7 +2260,7 @@ static int yy_get_next_buffer (void)
 				YY_FATAL_ERROR(
 				"fatal error - scanner input buffer overflow" );
 
-			(yy_c_buf_p) = &b->yy_ch_buf[yy_c_buf_p_offset];
+			yyg->yy_c_buf_p = &b->yy_ch_buf[yy_c_buf_p_offset];
 
 			num_to_read = YY_CURRENT_BUFFER_LVALUE->yy_buf_size -
 						number_to_move - 1;
@@ -2184,17 +2272,17 @@ static int yy_get_next_buffer (void)
 
 		/* Read in more data. */
 		YY_INPUT( (&YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[number_to_move]),
-			(yy_n_chars), num_to_read );
+			yyg->yy_n_chars, num_to_read );
 
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars;
 		}
 
-	if ( (yy_n_chars) == 0 )
+	if ( yyg->yy_n_chars == 0 )
 		{
 		if ( number_to_move == YY_MORE_ADJ )
 			{
 			ret_val = EOB_ACT_END_OF_FILE;
-			yyrestart( yyin  );
+			yyrestart( yyin , yyscanner );
 			}
 
 		else
@@ -2208,43 +2296,44 @@ static int yy_get_next_buffer (void)
 	else
 		ret_val = EOB_ACT_CONTINUE_SCAN;
 
-	if (((yy_n_chars) + number_to_move) > YY_CURRENT_BUFFER_LVALUE->yy_buf_size) {
+	if ((yyg->yy_n_chars + number_to_move) > YY_CURRENT_BUFFER_LVALUE->yy_buf_size) {
 		/* Extend the array by 50%, plus the number we really need. */
-		int new_size = (yy_n_chars) + number_to_move + ((yy_n_chars) >> 1);
+		int new_size = yyg->yy_n_chars + number_to_move + (yyg->yy_n_chars >> 1);
 		YY_CURRENT_BUFFER_LVALUE->yy_ch_buf = (char *) yyrealloc(
-			(void *) YY_CURRENT_BUFFER_LVALUE->yy_ch_buf, (yy_size_t) new_size  );
+			(void *) YY_CURRENT_BUFFER_LVALUE->yy_ch_buf, (yy_size_t) new_size , yyscanner );
 		if ( ! YY_CURRENT_BUFFER_LVALUE->yy_ch_buf )
 			YY_FATAL_ERROR( "out of dynamic memory in yy_get_next_buffer()" );
 		/* "- 2" to take care of EOB's */
 		YY_CURRENT_BUFFER_LVALUE->yy_buf_size = (int) (new_size - 2);
 	}
 
-	(yy_n_chars) += number_to_move;
-	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)] = YY_END_OF_BUFFER_CHAR;
-	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars) + 1] = YY_END_OF_BUFFER_CHAR;
+	yyg->yy_n_chars += number_to_move;
+	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars] = YY_END_OF_BUFFER_CHAR;
+	YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars + 1] = YY_END_OF_BUFFER_CHAR;
 
-	(yytext_ptr) = &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[0];
+	yyg->yytext_ptr = &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[0];
 
 	return ret_val;
 }
 
 /* yy_get_previous_state - get the state just before the EOB char was reached */
 
-    static yy_state_type yy_get_previous_state (void)
+    static yy_state_type yy_get_previous_state (yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	yy_state_type yy_current_state;
 	char *yy_cp;
     
-	yy_current_state = (yy_start);
+	yy_current_state = yyg->yy_start;
 	yy_current_state += YY_AT_BOL();
 
-	for ( yy_cp = (yytext_ptr) + YY_MORE_ADJ; yy_cp < (yy_c_buf_p); ++yy_cp )
+	for ( yy_cp = yyg->yytext_ptr + YY_MORE_ADJ; yy_cp < yyg->yy_c_buf_p; ++yy_cp )
 		{
 		YY_CHAR yy_c = (*yy_cp ? yy_ec[YY_SC_TO_UI(*yy_cp)] : 1);
 		if ( yy_accept[yy_current_state] )
 			{
-			(yy_last_accepting_state) = yy_current_state;
-			(yy_last_accepting_cpos) = yy_cp;
+			yyg->yy_last_accepting_state = yy_current_state;
+			yyg->yy_last_accepting_cpos = yy_cp;
 			}
 		while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 			{
@@ -2263,16 +2352,17 @@ static int yy_get_next_buffer (void)
  * synopsis
  *	next_state = yy_try_NUL_trans( current_state );
  */
-    static yy_state_type yy_try_NUL_trans  (yy_state_type yy_current_state )
+    static yy_state_type yy_try_NUL_trans  (yy_state_type yy_current_state , yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	int yy_is_jam;
-    	char *yy_cp = (yy_c_buf_p);
+    	char *yy_cp = yyg->yy_c_buf_p;
 
 	YY_CHAR yy_c = 1;
 	if ( yy_accept[yy_current_state] )
 		{
-		(yy_last_accepting_state) = yy_current_state;
-		(yy_last_accepting_cpos) = yy_cp;
+		yyg->yy_last_accepting_state = yy_current_state;
+		yyg->yy_last_accepting_cpos = yy_cp;
 		}
 	while ( yy_chk[yy_base[yy_current_state] + yy_c] != yy_current_state )
 		{
@@ -2288,19 +2378,20 @@ static int yy_get_next_buffer (void)
 
 #ifndef YY_NO_UNPUT
 
-    static void yyunput (int c, char * yy_bp )
+    static void yyunput (int c, char * yy_bp , yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	char *yy_cp;
     
-    yy_cp = (yy_c_buf_p);
+    yy_cp = yyg->yy_c_buf_p;
 
 	/* undo effects of setting up yytext */
-	*yy_cp = (yy_hold_char);
+	*yy_cp = yyg->yy_hold_char;
 
 	if ( yy_cp < YY_CURRENT_BUFFER_LVALUE->yy_ch_buf + 2 )
 		{ /* need to shift things up to make room */
 		/* +2 for EOB chars. */
-		int number_to_move = (yy_n_chars) + 2;
+		int number_to_move = yyg->yy_n_chars + 2;
 		char *dest = &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[
 					YY_CURRENT_BUFFER_LVALUE->yy_buf_size + 2];
 		char *source =
@@ -2312,7 +2403,7 @@ static int yy_get_next_buffer (void)
 		yy_cp += (int) (dest - source);
 		yy_bp += (int) (dest - source);
 		YY_CURRENT_BUFFER_LVALUE->yy_n_chars =
-			(yy_n_chars) = (int) YY_CURRENT_BUFFER_LVALUE->yy_buf_size;
+			yyg->yy_n_chars = (int) YY_CURRENT_BUFFER_LVALUE->yy_buf_size;
 
 		if ( yy_cp < YY_CURRENT_BUFFER_LVALUE->yy_ch_buf + 2 )
 			YY_FATAL_ERROR( "flex scanner push-back overflow" );
@@ -2320,41 +2411,42 @@ static int yy_get_next_buffer (void)
 
 	*--yy_cp = (char) c;
 
-	(yytext_ptr) = yy_bp;
-	(yy_hold_char) = *yy_cp;
-	(yy_c_buf_p) = yy_cp;
+	yyg->yytext_ptr = yy_bp;
+	yyg->yy_hold_char = *yy_cp;
+	yyg->yy_c_buf_p = yy_cp;
 }
 
 #endif
 
 #ifndef YY_NO_INPUT
 #ifdef __cplusplus
-    static int yyinput (void)
+    static int yyinput (yyscan_t yyscanner)
 #else
-    static int input  (void)
+    static int input  (yyscan_t yyscanner)
 #endif
 
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	int c;
     
-	*(yy_c_buf_p) = (yy_hold_char);
+	*yyg->yy_c_buf_p = yyg->yy_hold_char;
 
-	if ( *(yy_c_buf_p) == YY_END_OF_BUFFER_CHAR )
+	if ( *yyg->yy_c_buf_p == YY_END_OF_BUFFER_CHAR )
 		{
 		/* yy_c_buf_p now points to the character we want to return.
 		 * If this occurs *before* the EOB characters, then it's a
 		 * valid NUL; if not, then we've hit the end of the buffer.
 		 */
-		if ( (yy_c_buf_p) < &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[(yy_n_chars)] )
+		if ( yyg->yy_c_buf_p < &YY_CURRENT_BUFFER_LVALUE->yy_ch_buf[yyg->yy_n_chars] )
 			/* This was really a NUL. */
-			*(yy_c_buf_p) = '\0';
+			*yyg->yy_c_buf_p = '\0';
 
 		else
 			{ /* need more input */
-			int offset = (int) ((yy_c_buf_p) - (yytext_ptr));
-			++(yy_c_buf_p);
+			int offset = (int) (yyg->yy_c_buf_p - yyg->yytext_ptr);
+			++yyg->yy_c_buf_p;
 
-			switch ( yy_get_next_buffer(  ) )
+			switch ( yy_get_next_buffer( yyscanner ) )
 				{
 				case EOB_ACT_LAST_MATCH:
 					/* This happens because yy_g_n_b()
@@ -2368,34 +2460,34 @@ static int yy_get_next_buffer (void)
 					 */
 
 					/* Reset buffer status. */
-					yyrestart( yyin );
+					yyrestart( yyin , yyscanner );
 
 					/*FALLTHROUGH*/
 
 				case EOB_ACT_END_OF_FILE:
 					{
-					if ( yywrap(  ) )
+					if ( yywrap( yyscanner ) )
 						return 0;
 
-					if ( ! (yy_did_buffer_switch_on_eof) )
+					if ( ! yyg->yy_did_buffer_switch_on_eof )
 						YY_NEW_FILE;
 #ifdef __cplusplus
-					return yyinput();
+					return yyinput( yyscanner );
 #else
-					return input();
+					return input( yyscanner );
 #endif
 					}
 
 				case EOB_ACT_CONTINUE_SCAN:
-					(yy_c_buf_p) = (yytext_ptr) + offset;
+					yyg->yy_c_buf_p = yyg->yytext_ptr + offset;
 					break;
 				}
 			}
 		}
 
-	c = *(unsigned char *) (yy_c_buf_p);	/* cast for 8-bit char's */
-	*(yy_c_buf_p) = '\0';	/* preserve yytext */
-	(yy_hold_char) = *++(yy_c_buf_p);
+	c = *(unsigned char *) yyg->yy_c_buf_p;	/* cast for 8-bit char's */
+	*yyg->yy_c_buf_p = '\0';	/* preserve yytext */
+	yyg->yy_hold_char = *++yyg->yy_c_buf_p;
 
 	YY_CURRENT_BUFFER_LVALUE->yy_at_bol = (c == '\n');
 
@@ -2408,60 +2500,61 @@ static int yy_get_next_buffer (void)
  * 
  * @note This function does not reset the start condition to @c INITIAL .
  */
-    void yyrestart  (FILE * input_file )
+    void yyrestart  (FILE * input_file , yyscan_t yyscanner)
 {
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	if ( ! YY_CURRENT_BUFFER ){
-        yyensure_buffer_stack ();
+        yyensure_buffer_stack( yyscanner );
 		YY_CURRENT_BUFFER_LVALUE =
-            yy_create_buffer( yyin, YY_BUF_SIZE );
+            yy_create_buffer( yyin, YY_BUF_SIZE , yyscanner );
 	}
 
-	yy_init_buffer( YY_CURRENT_BUFFER, input_file );
-	yy_load_buffer_state(  );
+	yy_init_buffer( YY_CURRENT_BUFFER, input_file , yyscanner );
+	yy_load_buffer_state( yyscanner );
 }
 
 /** Switch to a different input buffer.
  * @param new_buffer The new input buffer.
  * 
  */
-    void yy_switch_to_buffer  (YY_BUFFER_STATE  new_buffer )
+    void yy_switch_to_buffer  (YY_BUFFER_STATE  new_buffer , yyscan_t yyscanner)
 {
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	/* TODO. We should be able to replace this entire function body
 	 * with
 	 *		yypop_buffer_state();
-	 *		yypush_buffer_state(new_buffer);
+	 *		ypush_buffer_state(new_buffer);
      */
-	yyensure_buffer_stack ();
+	yyensure_buffer_stack( yyscanner );
 	if ( YY_CURRENT_BUFFER == new_buffer )
 		return;
 
 	if ( YY_CURRENT_BUFFER )
 		{
 		/* Flush out information for old buffer. */
-		*(yy_c_buf_p) = (yy_hold_char);
-		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = (yy_c_buf_p);
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
+		*yyg->yy_c_buf_p = yyg->yy_hold_char;
+		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = yyg->yy_c_buf_p;
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars;
 		}
 
 	YY_CURRENT_BUFFER_LVALUE = new_buffer;
-	yy_load_buffer_state(  );
+	yy_load_buffer_state( yyscanner );
 
 	/* We don't actually know whether we did this switch during
 	 * EOF (yywrap()) processing, but the only time this flag
 	 * is looked at is after yywrap() is called, so it's safe
 	 * to go ahead and always set it.
 	 */
-	(yy_did_buffer_switch_on_eof) = 1;
+	yyg->yy_did_buffer_switch_on_eof = 1;
 }
 
-static void yy_load_buffer_state  (void)
+static void yy_load_buffer_state  (yyscan_t yyscanner)
 {
-    	(yy_n_chars) = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
-	(yytext_ptr) = (yy_c_buf_p) = YY_CURRENT_BUFFER_LVALUE->yy_buf_pos;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	yyg->yy_n_chars = YY_CURRENT_BUFFER_LVALUE->yy_n_chars;
+	yyg->yytext_ptr = yyg->yy_c_buf_p = YY_CURRENT_BUFFER_LVALUE->yy_buf_pos;
 	yyin = YY_CURRENT_BUFFER_LVALUE->yy_input_file;
-	(yy_hold_char) = *(yy_c_buf_p);
+	yyg->yy_hold_char = *yyg->yy_c_buf_p;
 }
 
 /** Allocate and initialize an input buffer state.
@@ -2470,11 +2563,11 @@ static void yy_load_buffer_state  (void)
  * 
  * @return the allocated buffer state.
  */
-    YY_BUFFER_STATE yy_create_buffer  (FILE * file, int  size )
+    YY_BUFFER_STATE yy_create_buffer  (FILE * file, int  size , yyscan_t yyscanner)
 {
 	YY_BUFFER_STATE b;
     
-	b = (YY_BUFFER_STATE) yyalloc( sizeof( struct yy_buffer_state )  );
+	b = (YY_BUFFER_STATE) yyalloc( sizeof( struct yy_buffer_state ) , yyscanner );
 	if ( ! b )
 		YY_FATAL_ERROR( "out of dynamic memory in yy_create_buffer()" );
 
@@ -2483,13 +2576,13 @@ static void yy_load_buffer_state  (void)
 	/* yy_ch_buf has to be 2 characters longer than the size given because
 	 * we need to put in 2 end-of-buffer characters.
 	 */
-	b->yy_ch_buf = (char *) yyalloc( (yy_size_t) (b->yy_buf_size + 2)  );
+	b->yy_ch_buf = (char *) yyalloc( (yy_size_t) (b->yy_buf_size + 2) , yyscanner );
 	if ( ! b->yy_ch_buf )
 		YY_FATAL_ERROR( "out of dynamic memory in yy_create_buffer()" );
 
 	b->yy_is_our_buffer = 1;
 
-	yy_init_buffer( b, file );
+	yy_init_buffer( b, file , yyscanner );
 
 	return b;
 }
@@ -2498,9 +2591,9 @@ static void yy_load_buffer_state  (void)
  * @param b a buffer created with yy_create_buffer()
  * 
  */
-    void yy_delete_buffer (YY_BUFFER_STATE  b )
+    void yy_delete_buffer (YY_BUFFER_STATE  b , yyscan_t yyscanner)
 {
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	if ( ! b )
 		return;
 
@@ -2508,21 +2601,22 @@ static void yy_load_buffer_state  (void)
 		YY_CURRENT_BUFFER_LVALUE = (YY_BUFFER_STATE) 0;
 
 	if ( b->yy_is_our_buffer )
-		yyfree( (void *) b->yy_ch_buf  );
+		yyfree( (void *) b->yy_ch_buf , yyscanner );
 
-	yyfree( (void *) b  );
+	yyfree( (void *) b , yyscanner );
 }
 
 /* Initializes or reinitializes a buffer.
  * This function is sometimes called more than once on the same buffer,
  * such as during a yyrestart() or at EOF.
  */
-    static void yy_init_buffer  (YY_BUFFER_STATE  b, FILE * file )
+    static void yy_init_buffer  (YY_BUFFER_STATE  b, FILE * file , yyscan_t yyscanner)
 
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	int oerrno = errno;
     
-	yy_flush_buffer( b );
+	yy_flush_buffer( b , yyscanner );
 
 	b->yy_input_file = file;
 	b->yy_fill_buffer = 1;
@@ -2545,9 +2639,10 @@ static void yy_load_buffer_state  (void)
  * @param b the buffer state to be flushed, usually @c YY_CURRENT_BUFFER.
  * 
  */
-    void yy_flush_buffer (YY_BUFFER_STATE  b )
+    void yy_flush_buffer (YY_BUFFER_STATE  b , yyscan_t yyscanner)
 {
-    	if ( ! b )
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	if ( ! b )
 		return;
 
 	b->yy_n_chars = 0;
@@ -2565,7 +2660,7 @@ static void yy_load_buffer_state  (void)
 	b->yy_buffer_status = YY_BUFFER_NEW;
 
 	if ( b == YY_CURRENT_BUFFER )
-		yy_load_buffer_state(  );
+		yy_load_buffer_state( yyscanner );
 }
 
 /** Pushes the new state onto the stack. The new state becomes
@@ -2574,95 +2669,98 @@ static void yy_load_buffer_state  (void)
  *  @param new_buffer The new state.
  *  
  */
-void yypush_buffer_state (YY_BUFFER_STATE new_buffer )
+void yypush_buffer_state (YY_BUFFER_STATE new_buffer , yyscan_t yyscanner)
 {
-    	if (new_buffer == NULL)
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	if (new_buffer == NULL)
 		return;
 
-	yyensure_buffer_stack();
+	yyensure_buffer_stack( yyscanner );
 
 	/* This block is copied from yy_switch_to_buffer. */
 	if ( YY_CURRENT_BUFFER )
 		{
 		/* Flush out information for old buffer. */
-		*(yy_c_buf_p) = (yy_hold_char);
-		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = (yy_c_buf_p);
-		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = (yy_n_chars);
+		*yyg->yy_c_buf_p = yyg->yy_hold_char;
+		YY_CURRENT_BUFFER_LVALUE->yy_buf_pos = yyg->yy_c_buf_p;
+		YY_CURRENT_BUFFER_LVALUE->yy_n_chars = yyg->yy_n_chars;
 		}
 
 	/* Only push if top exists. Otherwise, replace top. */
 	if (YY_CURRENT_BUFFER)
-		(yy_buffer_stack_top)++;
+		yyg->yy_buffer_stack_top++;
 	YY_CURRENT_BUFFER_LVALUE = new_buffer;
 
 	/* copied from yy_switch_to_buffer. */
-	yy_load_buffer_state(  );
-	(yy_did_buffer_switch_on_eof) = 1;
+	yy_load_buffer_state( yyscanner );
+	yyg->yy_did_buffer_switch_on_eof = 1;
 }
 
 /** Removes and deletes the top of the stack, if present.
  *  The next element becomes the new top.
  *  
  */
-void yypop_buffer_state (void)
+void yypop_buffer_state (yyscan_t yyscanner)
 {
-    	if (!YY_CURRENT_BUFFER)
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	if (!YY_CURRENT_BUFFER)
 		return;
 
-	yy_delete_buffer(YY_CURRENT_BUFFER );
+	yy_delete_buffer( YY_CURRENT_BUFFER , yyscanner );
 	YY_CURRENT_BUFFER_LVALUE = NULL;
-	if ((yy_buffer_stack_top) > 0)
-		--(yy_buffer_stack_top);
+	if (yyg->yy_buffer_stack_top > 0)
+		--yyg->yy_buffer_stack_top;
 
 	if (YY_CURRENT_BUFFER) {
-		yy_load_buffer_state(  );
-		(yy_did_buffer_switch_on_eof) = 1;
+		yy_load_buffer_state( yyscanner );
+		yyg->yy_did_buffer_switch_on_eof = 1;
 	}
 }
 
 /* Allocates the stack if it does not exist.
  *  Guarantees space for at least one push.
  */
-static void yyensure_buffer_stack (void)
+static void yyensure_buffer_stack (yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
 	yy_size_t num_to_alloc;
     
-	if (!(yy_buffer_stack)) {
+	if (!yyg->yy_buffer_stack) {
 
 		/* First allocation is just for 2 elements, since we don't know if this
 		 * scanner will even need a stack. We use 2 instead of 1 to avoid an
 		 * immediate realloc on the next call.
          */
       num_to_alloc = 1; /* After all that talk, this was set to 1 anyways... */
-		(yy_buffer_stack) = (struct yy_buffer_state**)yyalloc
+		yyg->yy_buffer_stack = (struct yy_buffer_state**)yyalloc
 								(num_to_alloc * sizeof(struct yy_buffer_state*)
-								);
-		if ( ! (yy_buffer_stack) )
+								, yyscanner);
+		if ( ! yyg->yy_buffer_stack )
 			YY_FATAL_ERROR( "out of dynamic memory in yyensure_buffer_stack()" );
 
-		memset((yy_buffer_stack), 0, num_to_alloc * sizeof(struct yy_buffer_state*));
+		memset(yyg->yy_buffer_stack, 0, num_to_alloc * sizeof(struct yy_buffer_state*));
 
-		(yy_buffer_stack_max) = num_to_alloc;
-		(yy_buffer_stack_top) = 0;
+		yyg->yy_buffer_stack_max = num_to_alloc;
+		yyg->yy_buffer_stack_top = 0;
 		return;
 	}
 
-	if ((yy_buffer_stack_top) >= ((yy_buffer_stack_max)) - 1){
+	if (yyg->yy_buffer_stack_top >= (yyg->yy_buffer_stack_max) - 1){
 
 		/* Increase the buffer to prepare for a possible push. */
 		yy_size_t grow_size = 8 /* arbitrary grow size */;
 
-		num_to_alloc = (yy_buffer_stack_max) + grow_size;
-		(yy_buffer_stack) = (struct yy_buffer_state**)yyrealloc
-								((yy_buffer_stack),
+		num_to_alloc = yyg->yy_buffer_stack_max + grow_size;
+		yyg->yy_buffer_stack = (struct yy_buffer_state**)yyrealloc
+								(yyg->yy_buffer_stack,
 								num_to_alloc * sizeof(struct yy_buffer_state*)
-								);
-		if ( ! (yy_buffer_stack) )
+								, yyscanner);
+		if ( ! yyg->yy_buffer_stack )
 			YY_FATAL_ERROR( "out of dynamic memory in yyensure_buffer_stack()" );
 
 		/* zero only the new slots.*/
-		memset((yy_buffer_stack) + (yy_buffer_stack_max), 0, grow_size * sizeof(struct yy_buffer_state*));
-		(yy_buffer_stack_max) = num_to_alloc;
+		memset(yyg->yy_buffer_stack + yyg->yy_buffer_stack_max, 0, grow_size * sizeof(struct yy_buffer_state*));
+		yyg->yy_buffer_stack_max = num_to_alloc;
 	}
 }
 
@@ -2672,7 +2770,7 @@ static void yyensure_buffer_stack (void)
  * 
  * @return the newly allocated buffer state object.
  */
-YY_BUFFER_STATE yy_scan_buffer  (char * base, yy_size_t  size )
+YY_BUFFER_STATE yy_scan_buffer  (char * base, yy_size_t  size , yyscan_t yyscanner)
 {
 	YY_BUFFER_STATE b;
     
@@ -2682,7 +2780,7 @@ YY_BUFFER_STATE yy_scan_buffer  (char * base, yy_size_t  size )
 		/* They forgot to leave room for the EOB's. */
 		return NULL;
 
-	b = (YY_BUFFER_STATE) yyalloc( sizeof( struct yy_buffer_state )  );
+	b = (YY_BUFFER_STATE) yyalloc( sizeof( struct yy_buffer_state ) , yyscanner );
 	if ( ! b )
 		YY_FATAL_ERROR( "out of dynamic memory in yy_scan_buffer()" );
 
@@ -2696,7 +2794,7 @@ YY_BUFFER_STATE yy_scan_buffer  (char * base, yy_size_t  size )
 	b->yy_fill_buffer = 0;
 	b->yy_buffer_status = YY_BUFFER_NEW;
 
-	yy_switch_to_buffer( b  );
+	yy_switch_to_buffer( b , yyscanner );
 
 	return b;
 }
@@ -2709,10 +2807,9 @@ YY_BUFFER_STATE yy_scan_buffer  (char * base, yy_size_t  size )
  * @note If you want to scan bytes that may contain NUL values, then use
  *       yy_scan_bytes() instead.
  */
-YY_BUFFER_STATE yy_scan_string (const char * yystr )
+YY_BUFFER_STATE yy_scan_string (const char * yystr , yyscan_t yyscanner)
 {
-    
-	return yy_scan_bytes( yystr, (int) strlen(yystr) );
+	return yy_scan_bytes( yystr, (int) strlen(yystr) , yyscanner );
 }
 
 /** Setup the input buffer state to scan the given bytes. The next call to yylex() will
@@ -2722,7 +2819,7 @@ YY_BUFFER_STATE yy_scan_string (const char * yystr )
  * 
  * @return the newly allocated buffer state object.
  */
-YY_BUFFER_STATE yy_scan_bytes  (const char * yybytes, int  _yybytes_len )
+YY_BUFFER_STATE yy_scan_bytes  (const char * yybytes, int  _yybytes_len , yyscan_t yyscanner)
 {
 	YY_BUFFER_STATE b;
 	char *buf;
@@ -2731,7 +2828,7 @@ YY_BUFFER_STATE yy_scan_bytes  (const char * yybytes, int  _yybytes_len )
     
 	/* Get memory for full buffer, including space for trailing EOB's. */
 	n = (yy_size_t) (_yybytes_len + 2);
-	buf = (char *) yyalloc( n  );
+	buf = (char *) yyalloc( n , yyscanner );
 	if ( ! buf )
 		YY_FATAL_ERROR( "out of dynamic memory in yy_scan_bytes()" );
 
@@ -2740,7 +2837,7 @@ YY_BUFFER_STATE yy_scan_bytes  (const char * yybytes, int  _yybytes_len )
 
 	buf[_yybytes_len] = buf[_yybytes_len+1] = YY_END_OF_BUFFER_CHAR;
 
-	b = yy_scan_buffer( buf, n );
+	b = yy_scan_buffer( buf, n , yyscanner );
 	if ( ! b )
 		YY_FATAL_ERROR( "bad buffer in yy_scan_bytes()" );
 
@@ -2756,8 +2853,10 @@ YY_BUFFER_STATE yy_scan_bytes  (const char * yybytes, int  _yybytes_len )
 #define YY_EXIT_FAILURE 2
 #endif
 
-static void yynoreturn yy_fatal_error (const char* msg )
+static void yynoreturn yy_fatal_error (const char* msg , yyscan_t yyscanner)
 {
+	struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	(void)yyg;
 			fprintf( stderr, "%s\n", msg );
 	exit( YY_EXIT_FAILURE );
 }
@@ -2771,106 +2870,237 @@ static void yynoreturn yy_fatal_error (const char* msg )
 		/* Undo effects of setting up yytext. */ \
         int yyless_macro_arg = (n); \
         YY_LESS_LINENO(yyless_macro_arg);\
-		yytext[yyleng] = (yy_hold_char); \
-		(yy_c_buf_p) = yytext + yyless_macro_arg; \
-		(yy_hold_char) = *(yy_c_buf_p); \
-		*(yy_c_buf_p) = '\0'; \
+		yytext[yyleng] = yyg->yy_hold_char; \
+		yyg->yy_c_buf_p = yytext + yyless_macro_arg; \
+		yyg->yy_hold_char = *yyg->yy_c_buf_p; \
+		*yyg->yy_c_buf_p = '\0'; \
 		yyleng = yyless_macro_arg; \
 		} \
 	while ( 0 )
 
 /* Accessor  methods (get/set functions) to struct members. */
 
+/** Get the user-defined data for this scanner.
+ * @param yyscanner The scanner object.
+ */
+YY_EXTRA_TYPE yyget_extra  (yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yyextra;
+}
+
 /** Get the current line number.
- * 
+ * @param yyscanner The scanner object.
  */
-int yyget_lineno  (void)
+int yyget_lineno  (yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
+        if (! YY_CURRENT_BUFFER)
+            return 0;
     
     return yylineno;
 }
 
+/** Get the current column number.
+ * @param yyscanner The scanner object.
+ */
+int yyget_column  (yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
+        if (! YY_CURRENT_BUFFER)
+            return 0;
+    
+    return yycolumn;
+}
+
 /** Get the input stream.
- * 
+ * @param yyscanner The scanner object.
  */
-FILE *yyget_in  (void)
+FILE *yyget_in  (yyscan_t yyscanner)
 {
-        return yyin;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yyin;
 }
 
 /** Get the output stream.
- * 
+ * @param yyscanner The scanner object.
  */
-FILE *yyget_out  (void)
+FILE *yyget_out  (yyscan_t yyscanner)
 {
-        return yyout;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yyout;
 }
 
 /** Get the length of the current token.
- * 
+ * @param yyscanner The scanner object.
  */
-int yyget_leng  (void)
+int yyget_leng  (yyscan_t yyscanner)
 {
-        return yyleng;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yyleng;
 }
 
 /** Get the current token.
- * 
+ * @param yyscanner The scanner object.
  */
 
-char *yyget_text  (void)
+char *yyget_text  (yyscan_t yyscanner)
 {
-        return yytext;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yytext;
+}
+
+/** Set the user-defined data. This data is never touched by the scanner.
+ * @param user_defined The data to be associated with this scanner.
+ * @param yyscanner The scanner object.
+ */
+void yyset_extra (YY_EXTRA_TYPE  user_defined , yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yyextra = user_defined ;
 }
 
 /** Set the current line number.
  * @param _line_number line number
- * 
+ * @param yyscanner The scanner object.
  */
-void yyset_lineno (int  _line_number )
+void yyset_lineno (int  _line_number , yyscan_t yyscanner)
 {
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
+        /* lineno is only valid if an input buffer exists. */
+        if (! YY_CURRENT_BUFFER )
+           YY_FATAL_ERROR( "yyset_lineno called with no buffer" );
     
     yylineno = _line_number;
 }
 
+/** Set the current column.
+ * @param _column_no column number
+ * @param yyscanner The scanner object.
+ */
+void yyset_column (int  _column_no , yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
+        /* column is only valid if an input buffer exists. */
+        if (! YY_CURRENT_BUFFER )
+           YY_FATAL_ERROR( "yyset_column called with no buffer" );
+    
+    yycolumn = _column_no;
+}
+
 /** Set the input stream. This does not discard the current
  * input buffer.
  * @param _in_str A readable stream.
- * 
+ * @param yyscanner The scanner object.
  * @see yy_switch_to_buffer
  */
-void yyset_in (FILE *  _in_str )
+void yyset_in (FILE *  _in_str , yyscan_t yyscanner)
 {
-        yyin = _in_str ;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yyin = _in_str ;
 }
 
-void yyset_out (FILE *  _out_str )
+void yyset_out (FILE *  _out_str , yyscan_t yyscanner)
 {
-        yyout = _out_str ;
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yyout = _out_str ;
 }
 
-int yyget_debug  (void)
+int yyget_debug  (yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    return yy_flex_debug;
+}
+
+void yyset_debug (int  _bdebug , yyscan_t yyscanner)
+{
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    yy_flex_debug = _bdebug ;
+}
+
+/* Accessor methods for yylval and yylloc */
+
+/* User-visible API */
+
+/* yylex_init is special because it creates the scanner itself, so it is
+ * the ONLY reentrant function that doesn't take the scanner as the last argument.
+ * That's why we explicitly handle the declaration, instead of using our macros.
+ */
+int yylex_init(yyscan_t* ptr_yy_globals)
 {
-        return yy_flex_debug;
+    if (ptr_yy_globals == NULL){
+        errno = EINVAL;
+        return 1;
+    }
+
+    *ptr_yy_globals = (yyscan_t) yyalloc ( sizeof( struct yyguts_t ), NULL );
+
+    if (*ptr_yy_globals == NULL){
+        errno = ENOMEM;
+        return 1;
+    }
+
+    /* By setting to 0xAA, we expose bugs in yy_init_globals. Leave at 0x00 for releases. */
+    memset(*ptr_yy_globals,0x00,sizeof(struct yyguts_t));
+
+    return yy_init_globals ( *ptr_yy_globals );
 }
 
-void yyset_debug (int  _bdebug )
+/* yylex_init_extra has the same functionality as yylex_init, but follows the
+ * convention of taking the scanner as the last argument. Note however, that
+ * this is a *pointer* to a scanner, as it will be allocated by this call (and
+ * is the reason, too, why this function also must handle its own declaration).
+ * The user defined value in the first argument will be available to yyalloc in
+ * the yyextra field.
+ */
+int yylex_init_extra( YY_EXTRA_TYPE yy_user_defined, yyscan_t* ptr_yy_globals )
 {
-        yy_flex_debug = _bdebug ;
+    struct yyguts_t dummy_yyguts;
+
+    yyset_extra (yy_user_defined, &dummy_yyguts);
+
+    if (ptr_yy_globals == NULL){
+        errno = EINVAL;
+        return 1;
+    }
+
+    *ptr_yy_globals = (yyscan_t) yyalloc ( sizeof( struct yyguts_t ), &dummy_yyguts );
+
+    if (*ptr_yy_globals == NULL){
+        errno = ENOMEM;
+        return 1;
+    }
+
+    /* By setting to 0xAA, we expose bugs in
+    yy_init_globals. Leave at 0x00 for releases. */
+    memset(*ptr_yy_globals,0x00,sizeof(struct yyguts_t));
+
+    yyset_extra (yy_user_defined, *ptr_yy_globals);
+
+    return yy_init_globals ( *ptr_yy_globals );
 }
 
-static int yy_init_globals (void)
+static int yy_init_globals (yyscan_t yyscanner)
 {
-        /* Initialization is the same as for the non-reentrant scanner.
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+    /* Initialization is the same as for the non-reentrant scanner.
      * This function is called from yylex_destroy(), so don't allocate here.
      */
 
-    (yy_buffer_stack) = NULL;
-    (yy_buffer_stack_top) = 0;
-    (yy_buffer_stack_max) = 0;
-    (yy_c_buf_p) = NULL;
-    (yy_init) = 0;
-    (yy_start) = 0;
+    yyg->yy_buffer_stack = NULL;
+    yyg->yy_buffer_stack_top = 0;
+    yyg->yy_buffer_stack_max = 0;
+    yyg->yy_c_buf_p = NULL;
+    yyg->yy_init = 0;
+    yyg->yy_start = 0;
+
+    yyg->yy_start_stack_ptr = 0;
+    yyg->yy_start_stack_depth = 0;
+    yyg->yy_start_stack =  NULL;
 
 /* Defined in main.c */
 #ifdef YY_STDINIT
@@ -2888,24 +3118,32 @@ static int yy_init_globals (void)
 }
 
 /* yylex_destroy is for both reentrant and non-reentrant scanners. */
-int yylex_destroy  (void)
+int yylex_destroy  (yyscan_t yyscanner)
 {
-    
+    struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+
     /* Pop the buffer stack, destroying each element. */
 	while(YY_CURRENT_BUFFER){
-		yy_delete_buffer( YY_CURRENT_BUFFER  );
+		yy_delete_buffer( YY_CURRENT_BUFFER , yyscanner );
 		YY_CURRENT_BUFFER_LVALUE = NULL;
-		yypop_buffer_state();
+		yypop_buffer_state(yyscanner);
 	}
 
 	/* Destroy the stack itself. */
-	yyfree((yy_buffer_stack) );
-	(yy_buffer_stack) = NULL;
+	yyfree(yyg->yy_buffer_stack , yyscanner);
+	yyg->yy_buffer_stack = NULL;
+
+    /* Destroy the start condition stack. */
+        yyfree( yyg->yy_start_stack , yyscanner );
+        yyg->yy_start_stack = NULL;
 
     /* Reset the globals. This is important in a non-reentrant scanner so the next time
      * yylex() is called, initialization will occur. */
-    yy_init_globals( );
+    yy_init_globals( yyscanner);
 
+    /* Destroy the main struct (reentrant only). */
+    yyfree ( yyscanner , yyscanner );
+    yyscanner = NULL;
     return 0;
 }
 
@@ -2934,13 +3172,17 @@ static int yy_flex_strlen (const char * s )
 }
 #endif
 
-void *yyalloc (yy_size_t  size )
+void *yyalloc (yy_size_t  size , yyscan_t yyscanner)
 {
+	struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	(void)yyg;
 			return malloc(size);
 }
 
-void *yyrealloc  (void * ptr, yy_size_t  size )
+void *yyrealloc  (void * ptr, yy_size_t  size , yyscan_t yyscanner)
 {
+	struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	(void)yyg;
 		
 	/* The cast to (char *) in the following accommodates both
 	 * implementations that use char* generic pointers, and those
@@ -2952,140 +3194,202 @@ void *yyrealloc  (void * ptr, yy_size_t  size )
 	return realloc(ptr, size);
 }
 
-void yyfree (void * ptr )
+void yyfree (void * ptr , yyscan_t yyscanner)
 {
+	struct yyguts_t * yyg = (struct yyguts_t*)yyscanner;
+	(void)yyg;
 			free( (char *) ptr );	/* see yyrealloc() for (char *) cast */
 }
 
 #define YYTABLES_NAME "yytables"
 
-#line 594 "src/docmark_token_lexers.l"
+#line 665 "src/docmark_token_lexers.l"
 
 
-static void lex(int mode, Token *token) {
-	size_t input_size = strlen(token->data);
-	char *input = (char *) malloc((input_size + 2) * sizeof(char));
-	strcpy(input, token->data);
-	input[input_size] = '\n';
-	input[input_size + 1] = '\0';
+DocmarkLexContext *create_lex_context(Arena *arena, TokenTree *tree) {
+	DocmarkLexContext *context = (DocmarkLexContext *)calloc(1, sizeof(DocmarkLexContext));
+	if (context == NULL || yylex_init_extra(context, &context->scanner) != 0) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	context->arena = arena;
+	context->tree = tree;
+	return context;
+}
 
-	yyin = fmemopen(input, strlen(token->data), "r");
-	current_token = token;
+void free_lex_context(DocmarkLexContext *context) {
+	if (context == NULL) {
+		return;
+	}
+
+	yylex_destroy(context->scanner);
+	free(context->buffer);
+	free(context);
+}
+
+static void lex(DocmarkLexContext *context, int mode, TokenId token) {
+	struct yyguts_t *yyg = (struct yyguts_t *)context->scanner; // Needed by `BEGIN` outside of the rules
+
+	// Synthesized text followed by the two NUL sentinels flex requires is scanned in place, as flex only writes
+	// to it transiently; the document, which is read-only, and other spans are scanned from a padded copy
+	const char *data = context->tree->tokens.text[token] + context->tree->tokens.data[token].offset;
+	size_t length = context->tree->tokens.data[token].length;
+	char *scan_data = (char *)data;
+	if (mode == LEX_ROOT || data[length] != '\0' || data[length + 1] != '\0') {
+		if (length + TOKEN_DATA_PADDING > context->buffer_size) {
+			context->buffer_size = length + TOKEN_DATA_PADDING;
+			context->buffer = realloc(context->buffer, context->buffer_size);
+			if (context->buffer == NULL) {
+				fprintf(stderr, "ERROR: Memory allocation failed\n");
+				exit(1);
+			}
+		}
+		memcpy(context->buffer, data, length);
+		memset(context->buffer + length, '\0', TOKEN_DATA_PADDING);
+		scan_data = context->buffer;
+	}
+
+	YY_BUFFER_STATE scan_buffer = yy_scan_buffer(scan_data, length + TOKEN_DATA_PADDING, context->scanner);
+	if (scan_buffer == NULL) {
+		fprintf(stderr, "ERROR: Token data is not terminated by scanner sentinels\n");
+		exit(1);
+	}
+	context->current_token = token;
+	context->scan_base = scan_data;
+	context->scan_end = scan_data + length;
+	context->run_length = 0;
+	++context->lex_calls;
+
+#ifdef DOCMARK_LEX_PROFILE
+	_Static_assert(sizeof(rule_names) / sizeof(rule_names[0]) == YY_NUM_RULES + 1, "Every rule must be named");
+	_Static_assert(sizeof(condition_names) / sizeof(condition_names[0]) == IN_PARAGRAPH + 1, "Every start condition must be named");
+#endif
+	PROFILE_LEX_ENTER(&lex_profile_names);
 
 	BEGIN(mode);
-	yylex();
+	yylex(context->scanner);
+	yy_delete_buffer(scan_buffer, context->scanner);
 
-	free(token->data);
-	free(input);
-	token->data = NULL;
-	mark_raw(token);
+	context->tree->tokens.data[token] = EMPTY_SPAN; // The children now view the data; the text still backs the attribute
+	mark_raw(context->tree, token);
+}
+
+/**
+ * @brief Lexes the inline markup of a token with the shared inline lexer rather than the scanner
+ */
+static int lex_inline(DocmarkLexContext *context, TokenId token) {
+	++context->lex_calls;
+	lex_inline_token(context->tree, token);
+	return 0;
 }
 
-int lex_root(Token *token) {
-	lex(LEX_ROOT, token);
+int lex_root(DocmarkLexContext *context, TokenId token) {
+	context->in_left_column = 0; // Column state must not carry over between documents
+	context->in_right_column = 0;
+	lex(context, LEX_ROOT, token);
 }
 
-int lex_heading(Token *token) {
-	lex(LEX_HEADING, token);
+int lex_heading(DocmarkLexContext *context, TokenId token) {
+	return lex_inline(context, token);
 }
 
-int lex_italic(Token *token) {
-	lex(LEX_ITALIC, token);
+int lex_italic(DocmarkLexContext *context, TokenId token) {
+	return lex_inline(context, token);
 }
 
-int lex_bold(Token *token) {
-	lex(LEX_BOLD, token);
+int lex_bold(DocmarkLexContext *context, TokenId token) {
+	return lex_inline(context, token);
 }
 
-int lex_underscore(Token *token) {
-	lex(LEX_UNDERSCORE, token);
+int lex_underscore(DocmarkLexContext *context, TokenId token) {
+	return lex_inline(context, token);
 }
 
-int lex_strikethrough(Token *token) {
-	lex(LEX_STRIKETHROUGH, token);
+int lex_strikethrough(DocmarkLexContext *context, TokenId token) {
+	return lex_inline(context, token);
 }
 
-int lex_highlight(Token *token) {
-	lex(LEX_HIGHLIGHT, token);
+int lex_highlight(DocmarkLexContext *context, TokenId token) {
+	return lex_inline(context, token);
 }
 
-int lex_superscript(Token *token) {
-	lex(LEX_SUPERSCRIPT, token);
+int lex_superscript(DocmarkLexContext *context, TokenId token) {
+	return lex_inline(context, token);
 }
 
-int lex_subscript(Token *token) {
-	lex(LEX_SUBSCRIPT, token);
+int lex_subscript(DocmarkLexContext *context, TokenId token) {
+	return lex_inline(context, token);
 }
 
-int lex_blockquote(Token *token) {
-	lex(LEX_BLOCKQUOTE, token);
+int lex_blockquote(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_BLOCKQUOTE, token);
 }
 
-int lex_list_element(Token *token) {
-	lex(LEX_LIST_ELEMENT, token);
+int lex_list_element(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_LIST_ELEMENT, token);
 }
 
-int lex_description_list_key(Token *token) {
-	lex(LEX_DESCRIPTION_LIST_KEY, token);
+int lex_description_list_key(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_DESCRIPTION_LIST_KEY, token);
 }
 
-int lex_description_list_value(Token *token) {
-	lex(LEX_DESCRIPTION_LIST_VALUE, token);
+int lex_description_list_value(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_DESCRIPTION_LIST_VALUE, token);
 }
 
-int lex_link(Token *token) {
-	lex(LEX_LINK, token);
+int lex_link(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_LINK, token);
 }
 
-int lex_image(Token *token) {
-	lex(LEX_IMAGE, token);
+int lex_image(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_IMAGE, token);
 }
 
-int lex_audio(Token *token) {
-	lex(LEX_AUDIO, token);
+int lex_audio(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_AUDIO, token);
 }
 
-int lex_video(Token *token) {
-	lex(LEX_VIDEO, token);
+int lex_video(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_VIDEO, token);
 }
 
-int lex_top_titled_table(Token *token) {
-	lex(LEX_TOP_TITLED_TABLE, token);
+int lex_top_titled_table(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_TOP_TITLED_TABLE, token);
 }
 
-int lex_left_titled_table(Token *token) {
-	lex(LEX_LEFT_TITLED_TABLE, token);
+int lex_left_titled_table(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_LEFT_TITLED_TABLE, token);
 }
 
-int lex_two_way_table(Token *token) {
-	lex(LEX_TWO_WAY_TABLE, token);
+int lex_two_way_table(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_TWO_WAY_TABLE, token);
 }
 
-int lex_infobox_title(Token *token) {
-	lex(LEX_INFOBOX_TITLE, token);
+int lex_infobox_title(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_INFOBOX_TITLE, token);
 }
 
-int lex_infobox_content(Token *token) {
-	lex(LEX_INFOBOX_CONTENT, token);
+int lex_infobox_content(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_INFOBOX_CONTENT, token);
 }
 
-int lex_footnote_note(Token *token) {
-	lex(LEX_FOOTNOTE_NOTE, token);
+int lex_footnote_note(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_FOOTNOTE_NOTE, token);
 }
 
-int lex_endnote_note(Token *token) {
-	lex(LEX_ENDNOTE_NOTE, token);
+int lex_endnote_note(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_ENDNOTE_NOTE, token);
 }
 
-int lex_paragraph(Token *token) {
-	lex(LEX_PARAGRAPH, token);
+int lex_paragraph(DocmarkLexContext *context, TokenId token) {
+	return lex_inline(context, token);
 }
 
-int lex_indented_paragraph(Token *token) {
-	lex(LEX_INDENTED_PARAGRAPH, token);
+int lex_indented_paragraph(DocmarkLexContext *context, TokenId token) {
+	lex(context, LEX_INDENTED_PARAGRAPH, token);
 }
 
-int lex_(Token *token) {
+int lex_(DocmarkLexContext *context, TokenId token) {
 	// printf("WARNING: Token is not being lexed: uses `lex_()` as lexing function\n");
 	// print_token("", token);
 	return 0;
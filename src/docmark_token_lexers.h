@@ -1,230 +1,297 @@
 #ifndef DOCMARK_LEXERS_H
 #define DOCMARK_LEXERS_H
 
+#include "arena.h"
 #include "docmark_token.h"
 
+#include <stddef.h>
+
+/**
+ * @brief The state of a single lexer, so that separate documents may be lexed concurrently
+ */
+typedef struct DocmarkLexContext {
+	void *scanner; // The reentrant flex scanner (yyscan_t)
+	Arena *arena; // Owns synthesized token text
+	TokenTree *tree; // Receives every token added while lexing
+	TokenId current_token; // The token whose children are being added
+
+	unsigned int heading_rank;
+	int in_left_column;
+	int in_right_column;
+	int last_condition;
+
+	const char *scan_base; // Where the current token's data begins in the buffer being scanned
+	const char *scan_end; // Where it ends, just before the scanner sentinels
+	const char *run_start; // The pending run of plain text, which is flushed as a single token
+	size_t run_length;
+
+	char *buffer; // A padded copy of token data which cannot be scanned in place
+	size_t buffer_size;
+
+	size_t lex_calls; // How many times a lexer has been run over a token's text, for `--stats`
+} DocmarkLexContext;
+
+/**
+ * @brief Creates a lexing context; a context must only be used by one thread at a time
+ * 
+ * @param arena The arena from which synthesized token text is allocated
+ * @param tree The tree to which tokens are added
+ * @return DocmarkLexContext*
+ */
+DocmarkLexContext *create_lex_context(Arena *arena, TokenTree *tree);
+
+void free_lex_context(DocmarkLexContext *context);
+
 /**
  * @brief Lexes a root token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_root(Token *token);
+int lex_root(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a heading token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_heading(Token *token);
+int lex_heading(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes an italic token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_italic(Token *token);
+int lex_italic(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a bold token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_bold(Token *token);
+int lex_bold(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes an underscore token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_underscore(Token *token);
+int lex_underscore(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a strikethrough token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_strikethrough(Token *token);
+int lex_strikethrough(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a highlight token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_highlight(Token *token);
+int lex_highlight(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a superscript token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_superscript(Token *token);
+int lex_superscript(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a subscript token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_subscript(Token *token);
+int lex_subscript(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a blockquote token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_blockquote(Token *token);
+int lex_blockquote(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes an ordered list token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_ordered_list(Token *token);
+int lex_ordered_list(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes an unordered list token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_unordered_list(Token *token);
+int lex_unordered_list(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a description list token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_description_list(Token *token);
+int lex_description_list(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a list element token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_list_element(Token *token);
+int lex_list_element(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a description list key token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_description_list_key(Token *token);
+int lex_description_list_key(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a description list value token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_description_list_value(Token *token);
+int lex_description_list_value(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a link token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_link(Token *token);
+int lex_link(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes an image token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_image(Token *token);
+int lex_image(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes an audio token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_audio(Token *token);
+int lex_audio(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a video token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_video(Token *token);
+int lex_video(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a top titled table token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_top_titled_table(Token *token);
+int lex_top_titled_table(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a left titled table token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_left_titled_table(Token *token);
+int lex_left_titled_table(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a two way table token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_two_way_table(Token *token);
+int lex_two_way_table(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes an endnote note title token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_footnote_note(Token *token);
+int lex_footnote_note(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a footnote note title token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_endnote_note(Token *token);
+int lex_endnote_note(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes a paragraph token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_paragraph(Token *token);
+int lex_paragraph(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Lexes an indented paragraph token
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_indented_paragraph(Token *token);
+int lex_indented_paragraph(DocmarkLexContext *context, TokenId token);
 
 /**
  * @brief Placeholder lexing function (NOT TO BE USED IN FINAL VERSION)
  * 
+ * @param context The lexing context of the document being lexed
  * @param token The token to be lexed
  * @return int (0 on success, -1 on failure)
  */
-int lex_(Token *token);
+int lex_(DocmarkLexContext *context, TokenId token);
 
 #endif
\ No newline at end of file
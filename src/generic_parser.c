@@ -7,16 +7,10 @@
 #include <string.h>
 
 #include "docmark_debug.h"
+#include "html_escape.h"
+#include "output_sink.h"
 
-/* LOCAL PARSING VARIABLES */
-static int in_blockquote;
-static unsigned int blockquote_rank = 0;
-
-static int in_unordered_list;
-static unsigned int unordered_list_rank = 0;
-
-static int in_ordered_list;
-static unsigned int ordered_list_rank = 0;
+#define MAX_SUFFIX_LENGTH 11 // A dash and the digits of an unsigned int
 
 static inline char* format_data_buffer(const char* format, ...) {
 	va_list args;
@@ -56,6 +50,13 @@ static inline char* generate_identifier_base(const char* data) {
 	char buffer[256];
 	buffer[buffer_counter] = '\0';
 	while (data[i] != '\0') {
+		if (data[i] == '&') { // Character references written by the escaper carry no identifier text
+			const char *reference_end = strchr(data + i, ';');
+			if (reference_end) {
+				i = reference_end - data + 1;
+				continue;
+			}
+		}
 		if (data[i] == '<' && data[(i > 0 ? i : 0)] != '\\') {
 			in_tag = 1; // Set flag when entering a tag
 		}
@@ -90,283 +91,338 @@ static inline char* generate_identifier_base(const char* data) {
 	return identifier;
 }
 
+/**
+ * @brief Registers an identifier, appending a numeric suffix if it is already in use
+ * 
+ * @param identifier_base The requested identifier, which the function takes ownership of
+ * @return char* The registered identifier, owned by the caller
+ */
 static inline char* make_unique_identifier(char* identifier_base, IdentifierArray* heading_identifier_array, IdentifierArray* other_identifier_array, int is_header) {
-	int unique = 1;
-	for (int i = 0; i < heading_identifier_array->count; ++i) {
-		if (!strcmp(identifier_base, heading_identifier_array->identifiers[i])) {
-			unique = 0;
-			break;
-		}
-	}
-	for (int i = 0; i < other_identifier_array->count; ++i) {
-		if (!strcmp(identifier_base, other_identifier_array->identifiers[i])) {
-			unique = 0;
-			break;
-		}
+	IdentifierArray* target_array = is_header ? heading_identifier_array : other_identifier_array;
+
+	// Identifiers are unique across both arrays, so each lives in exactly one of them
+	IdentifierArray* base_array = heading_identifier_array;
+	size_t base_index = find_identifier(heading_identifier_array, identifier_base);
+	if (base_index == IDENTIFIER_NOT_FOUND) {
+		base_array = other_identifier_array;
+		base_index = find_identifier(other_identifier_array, identifier_base);
 	}
 
-	if (unique) {
-		if (is_header) {
-			add_identifier(heading_identifier_array, identifier_base);
-		} else {
-			add_identifier(other_identifier_array, identifier_base);
-		}
+	if (base_index == IDENTIFIER_NOT_FOUND) {
+		add_identifier(target_array, identifier_base);
 		return identifier_base;
 	}
-	
-	int suffix_num = 1;
-	char suffix[5];
-	char* identifier = (char *) malloc((strlen(identifier_base) + sizeof(suffix) + 1) * sizeof(char));
+
+	// Identifiers are never removed, so every suffix below the base's counter is still taken
+	size_t base_length = strlen(identifier_base);
+	char* identifier = (char *) malloc((base_length + MAX_SUFFIX_LENGTH + 1) * sizeof(char));
 	if (identifier == NULL) {
 		fprintf(stderr, "ERROR: Memory allocation failed\n");
 		exit(1);
 	}
+	memcpy(identifier, identifier_base, base_length);
 
+	unsigned int suffix_num = base_array->next_suffixes[base_index];
 	while (1) {
-		identifier[0] = '\0';
-		int suffix_size = snprintf(suffix, sizeof(suffix), "-%d", suffix_num);
-		if (suffix_size >= sizeof(suffix)) {
-			printf("ERROR: Identifier suffix size exceeded buffer\n");
-			exit(1);
+		snprintf(identifier + base_length, MAX_SUFFIX_LENGTH + 1, "-%u", suffix_num);
+		if (
+			find_identifier(heading_identifier_array, identifier) == IDENTIFIER_NOT_FOUND &&
+			find_identifier(other_identifier_array, identifier) == IDENTIFIER_NOT_FOUND
+		) {
+			break;
 		}
+		++suffix_num;
+	}
+
+	base_array->next_suffixes[base_index] = suffix_num + 1;
+	add_identifier(target_array, identifier);
+	free(identifier_base);
+	return identifier;
+}
 
-		strcat(identifier, identifier_base);
-		strcat(identifier, suffix);
-		unique = 1;
+/**
+ * @brief Copies the attribute of a token into a NUL-terminated string
+ * 
+ * @param token The token whose attribute is to be copied
+ * @return char* The attribute, owned by the caller (NULL if the token has none)
+ */
+static inline char* copy_attribute(TokenTree *tree, TokenId token) {
+	if (tree->tokens.attribute[token].length == 0) {
+		return NULL;
+	}
 
-		for (int i = 0; i < heading_identifier_array->count; ++i) {
-			if (!strcmp(identifier, heading_identifier_array->identifiers[i])) {
-				unique = 0;
-				break;
-			}
-		}
-		for (int i = 0; i < other_identifier_array->count; ++i) {
-			if (!strcmp(identifier, other_identifier_array->identifiers[i])) {
-				unique = 0;
-				break;
-			}
-		}
+	char* attribute = strndup(tree->tokens.text[token] + tree->tokens.attribute[token].offset, tree->tokens.attribute[token].length);
+	if (attribute == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	return attribute;
+}
 
-		if (unique) {
-			if (is_header) {
-				add_identifier(heading_identifier_array, identifier);
-			} else {
-				add_identifier(other_identifier_array, identifier);
-			}
-			free(identifier_base);
-			return identifier;
+/**
+ * @brief Writes a value for a quoted attribute; a missing value is written as an empty one
+ */
+static void write_attribute_value(OutputSink *sink, const char *value) {
+	if (value) {
+		sink_puts_escaped(sink, value, ESCAPE_ATTRIBUTE);
+	}
+}
+
+static void write_text(OutputSink *sink, const char *text) {
+	if (text) {
+		sink_puts_escaped(sink, text, ESCAPE_TEXT);
+	}
+}
+
+#define INITIAL_SINK_CAPACITY 4
+
+/**
+ * @brief The state of a parse, which walks the tree iteratively
+ */
+typedef struct ParseState {
+	TokenTree *tree;
+	IdentifierArray *heading_identifier_array;
+	IdentifierArray *other_identifier_array;
+
+	// The document's sink, and above it the sink which each open heading collects its text in
+	OutputSink **sinks;
+	size_t sink_count;
+	size_t sink_capacity;
+} ParseState;
+
+static OutputSink *current_sink(ParseState *state) {
+	return state->sinks[state->sink_count - 1];
+}
+
+static void push_sink(ParseState *state, OutputSink *sink) {
+	if (state->sink_count == state->sink_capacity) {
+		state->sink_capacity = (state->sink_capacity == 0) ? INITIAL_SINK_CAPACITY : state->sink_capacity * 2;
+		state->sinks = (OutputSink **)realloc(state->sinks, state->sink_capacity * sizeof(OutputSink *));
+		if (state->sinks == NULL) {
+			fprintf(stderr, "ERROR: Memory allocation failed\n");
+			exit(1);
 		}
-		++suffix_num;
 	}
+	state->sinks[state->sink_count++] = sink;
+}
+
+/**
+ * @brief Writes the data of a token, which precedes its children, escaped for where it lands
+ */
+static void write_data_escaped(OutputSink *sink, TokenTree *tree, TokenId token, EscapeMode mode) {
+	if (tree->tokens.text[token]) {
+		sink_write_escaped_borrowed(sink, tree->tokens.text[token] + tree->tokens.data[token].offset, tree->tokens.data[token].length, mode);
+	}
+}
+
+static void write_data(OutputSink *sink, TokenTree *tree, TokenId token) {
+	write_data_escaped(sink, tree, token, ESCAPE_TEXT);
+}
+
+static void close_heading(ParseState *state, TokenId token) {
+	// The identifier is derived from the rendered heading text, so the text was collected first
+	OutputSink *heading_sink = state->sinks[--state->sink_count];
+	OutputSink *sink = current_sink(state);
+
+	char *identifier_base = copy_attribute(state->tree, token);
+	if (identifier_base == NULL) {
+		identifier_base = generate_identifier_base(heading_sink->buffer);
+	}
+
+	char *identifier = make_unique_identifier(identifier_base, state->heading_identifier_array, state->other_identifier_array, 1);
+
+	sink_printf(sink, "<h%i type=\"", state->tree->tokens.rank[token]);
+	write_attribute_value(sink, identifier);
+	sink_write_literal(sink, "\">");
+	sink_write(sink, heading_sink->buffer, heading_sink->length);
+	sink_printf(sink, "</h%i>\n", state->tree->tokens.rank[token]);
+	free_sink(heading_sink);
+	free(identifier);
 }
 
-char *parse_token(Token *token, IdentifierArray* heading_identifier_array, IdentifierArray* other_identifier_array) {
-	if (token->type > 0) {
+typedef struct TagFragments {
+	const char *open;
+	size_t open_length;
+	const char *close;
+	size_t close_length;
+} TagFragments;
+
+#define TAGS(open, close) {open, sizeof(open) - 1, close, sizeof(close) - 1}
+
+/**
+ * @brief The markup around the content of each token type without attributes, indexed by type
+ */
+static const TagFragments tag_table[] = {
+	[RAW_DATA] = TAGS("", ""),
+	[ROOT] = TAGS("", ""),
+	[ITALIC] = TAGS("<i>", "</i>"),
+	[BOLD] = TAGS("<b>", "</b>"),
+	[UNDERSCORE] = TAGS("<u>", "</u>"),
+	[STRIKETHROUGH] = TAGS("<s>", "</s>"),
+	[HIGHLIGHT] = TAGS("<mark>", "</mark>"),
+	[SUPERSCRIPT] = TAGS("<sup>", "</sup>"),
+	[SUBSCRIPT] = TAGS("<sub>", "</sub>"),
+	[BLOCKQUOTE] = TAGS("<blockquote>\n", "\n</blockquote>\n"),
+	[ORDERED_LIST] = TAGS("<ol>\n", "</ol>\n"),
+	[UNORDERED_LIST] = TAGS("<ul>\n", "</ul>\n"),
+	[DESCRIPTION_LIST] = TAGS("<dl>\n", "</dl>\n"),
+	[LIST_ELEMENT] = TAGS("<li>\n", "</li>\n"),
+	[DESCRIPTION_LIST_KEY] = TAGS("<dt>", "</dt>\n"),
+	[DESCRIPTION_LIST_VALUE] = TAGS("<dd>", "</dd>\n"),
+	[INLINE_CODE] = TAGS("<code>", "</code>"),
+	[PARAGRAPH] = TAGS("<p>", "</p>\n"),
+	[INDENTED_PARAGRAPH] = TAGS("<p class=\"indented\">", "</p>\n"),
+};
+
+#define TAG_TABLE_SIZE (sizeof(tag_table) / sizeof(tag_table[0]))
+
+/**
+ * @brief Writes everything which precedes the children of a token
+ *
+ * @return int Whether the token's children are written, in which case `close_token()` must follow them
+ */
+static int open_token(ParseState *state, TokenId token) {
+	TokenTree *tree = state->tree;
+	OutputSink *sink = current_sink(state);
+	TRACE_TOKEN(TRACE_PARSE, tree, token);
+
+	mark_raw(tree, token);
+	if (tree->tokens.type[token] > 0) {
 		fprintf(stderr, "ERROR: Cannot parse token; token is not raw\n");
-		print_token("", token);
-		exit(1);
-	} else if (token->num_children != 0 || token->children != NULL) {
-		fprintf(stderr, "ERROR: Cannot parse token; token has %i children!\n", token->num_children);
-		print_token("PARENT", token);
-		for (int i = 0; i < token->num_children; i++) {
-			print_token("CHILD", token->children[i]);
-		}
+		print_token("", tree, token);
 		exit(1);
 	}
 
-	switch (token->type) {
+	TokenType type = tree->tokens.type[token];
+	if (type <= 0 && (size_t)-type < TAG_TABLE_SIZE && tag_table[-type].open) {
+		const TagFragments *tags = &tag_table[-type];
+		sink_write(sink, tags->open, tags->open_length);
+		write_data(sink, tree, token);
+		return 1;
+	}
+
+	switch ((int)type) { // As an int, since the raw types are the negated enumerators
 		case HORIZONTAL_RULE:
-			return "<hr>\n";
+			sink_write_literal(sink, "<hr>\n");
+			return 0;
 		case FOOTNOTE_REFERENCE: {
+			char* attribute = copy_attribute(tree, token);
 			char* header_id;
-			if (heading_identifier_array->count <= 0) {
+			if (state->heading_identifier_array->count <= 0) {
 				header_id = "base";
 			} else {
-				header_id = heading_identifier_array->identifiers[heading_identifier_array->count - 1];
+				header_id = state->heading_identifier_array->identifiers[state->heading_identifier_array->count - 1];
 			}
 
-			char *footnote_identifier_base = format_data_buffer("%s-footnote-%s", header_id, token->attribute);
-			char *footnote_identifier = make_unique_identifier(footnote_identifier_base, heading_identifier_array, other_identifier_array, 0);
-			free(footnote_identifier_base);
-
-			return format_data_buffer(
-				"<sup><a href=\"#%s\">%s</a></sup>\n",
-				footnote_identifier,
-				token->attribute
-			);
+			char *footnote_identifier_base = format_data_buffer("%s-footnote-%s", header_id, attribute);
+			char *footnote_identifier = make_unique_identifier(footnote_identifier_base, state->heading_identifier_array, state->other_identifier_array, 0);
+
+			sink_write_literal(sink, "<sup><a href=\"#");
+			write_attribute_value(sink, footnote_identifier);
+			sink_write_literal(sink, "\">");
+			write_text(sink, attribute);
+			sink_write_literal(sink, "</a></sup>\n");
+			free(footnote_identifier);
+			free(attribute);
+			return 0;
 		}
 		case ENDNOTE_REFERENCE: {
-			char *endnote_identifier_base = format_data_buffer("endnote-%s", token->attribute);
-			char *endnote_identifier = make_unique_identifier(endnote_identifier_base, heading_identifier_array, other_identifier_array, 0);
-			free(endnote_identifier_base);
-
-			return format_data_buffer(
-				"<sup><a href=\"#%s\">[%s]</a></sup>\n",
-				endnote_identifier,
-				token->attribute
-			);
+			char* attribute = copy_attribute(tree, token);
+			char *endnote_identifier_base = format_data_buffer("endnote-%s", attribute);
+			char *endnote_identifier = make_unique_identifier(endnote_identifier_base, state->heading_identifier_array, state->other_identifier_array, 0);
+
+			sink_write_literal(sink, "<sup><a href=\"#");
+			write_attribute_value(sink, endnote_identifier);
+			sink_write_literal(sink, "\">[");
+			write_text(sink, attribute);
+			sink_write_literal(sink, "]</a></sup>\n");
+			free(endnote_identifier);
+			free(attribute);
+			return 0;
 		}
 		case START_CODE_BLOCK:
-			return "<pre>\n<code>\n";
+			sink_write_literal(sink, "<pre>\n<code>\n");
+			return 0;
 		case END_CODE_BLOCK:
-			return "</code>\n</pre>\n";
+			sink_write_literal(sink, "</code>\n</pre>\n");
+			return 0;
 		case LEFT_COLUMN:
-			return "<div class=\"column-box\">\n<div class=\"column\">\n";
+			sink_write_literal(sink, "<div class=\"column-box\">\n<div class=\"column\">\n");
+			return 0;
 		case DIVIDER_COLUMN:
-			return "</div>\n<div class=\"column\">\n";
+			sink_write_literal(sink, "</div>\n<div class=\"column\">\n");
+			return 0;
 		case RIGHT_COLUMN:
-			return "</div>\n</div>\n";
-		case RAW_DATA: {
-			int length = strlen(token->data);
-			char *data = (char *)malloc(length + 1);
-			if (data == NULL) {
-				fprintf(stderr, "ERROR: Memory allocation failed\n");
-				exit(1);
-			}
-			strncpy(data, token->data, length);
-			data[length] = '\0';
-			return data;
-		}
-		case -ROOT:
-			printf("HIT ROOT\n");
-			// end tree traversal
-			return strdup(token->data);
+			sink_write_literal(sink, "</div>\n</div>\n");
+			return 0;
 		case -HEADING:
-			if (!token->attribute) {
-				token->attribute = generate_identifier_base(token->data);
-			}
-
-			token->attribute = make_unique_identifier(token->attribute, heading_identifier_array, other_identifier_array, 1);
-
-			return format_data_buffer(
-				"<h%i type=\"%s\">%s</h%i>\n",
-				token->rank,
-				token->attribute,
-				token->data,
-				token->rank
-			);
-		case -ITALIC:
-			return format_data_buffer(
-				"<i>%s</i>",
-				token->data
-			);
-		case -BOLD:
-			return format_data_buffer(
-				"<b>%s</b>",
-				token->data
-			);
-		case -UNDERSCORE:
-			return format_data_buffer(
-				"<u>%s</u>",
-				token->data
-			);
-		case -STRIKETHROUGH:
-			return format_data_buffer(
-				"<s>%s</s>",
-				token->data
-			);
-		case -HIGHLIGHT:
-			return format_data_buffer(
-				"<mark>%s</mark>",
-				token->data
-			);
-		case -SUPERSCRIPT:
-			return format_data_buffer(
-				"<sup>%s</sup>",
-				token->data
-			);
-		case -SUBSCRIPT:
-			return format_data_buffer(
-				"<sub>%s</sub>",
-				token->data
-			);
-		case -BLOCKQUOTE: {
-			return format_data_buffer(
-				"<blockquote>\n%s\n</blockquote>\n",
-				token->data
-			);
+			push_sink(state, create_memory_sink());
+			write_data(current_sink(state), tree, token);
+			return 1;
+		case -LINK: {
+			char* attribute = copy_attribute(tree, token);
+			char* attribute_state;
+			const char* source = strtok_r(attribute, "\0", &attribute_state);
+			const char* title = strtok_r(NULL, "\0", &attribute_state);
+			sink_write_literal(sink, "<a href=\"");
+			write_attribute_value(sink, source);
+			sink_write_literal(sink, "\" title=\"");
+			write_attribute_value(sink, title);
+			sink_write_literal(sink, "\">");
+			write_data(sink, tree, token);
+			free(attribute);
+			return 1;
 		}
-		case -ORDERED_LIST:
-			return format_data_buffer(
-				"<ol>\n%s</ol>\n",
-				token->data
-			);
-		case -UNORDERED_LIST:
-			return format_data_buffer(
-				"<ul>\n%s</ul>\n",
-				token->data
-			);
-			case -DESCRIPTION_LIST:
-			return format_data_buffer(
-				"<dl>\n%s</dl>\n",
-				token->data
-			);
-		case -LIST_ELEMENT:
-			return format_data_buffer(
-				"<li>\n%s</li>\n",
-				token->data
-			);
-		case -DESCRIPTION_LIST_KEY:
-			return format_data_buffer(
-				"<dt>%s</dt>\n",
-				token->data
-			);
-		case -DESCRIPTION_LIST_VALUE:
-			return format_data_buffer(
-				"<dd>%s</dd>\n",
-				token->data
-			);
-		case -INLINE_CODE:
-			return format_data_buffer(
-				"<code>%s</code>",
-				token->data
-			);
-		case -LINK:
-			return format_data_buffer(
-				"<a href=\"%s\" title=\"%s\">%s</a>\n",
-				strtok(token->attribute, "\0"),
-				strtok(NULL, "\0"),
-				token->data
-			);
 		case -IMAGE: {
-			const char* source = strtok(token->attribute, "\0");
-			const char* title = strtok(NULL, "\0");
-			return format_data_buffer(
-				"<img src=\"%s\" alt=\"%s\" title=\"%s\">\n",
-				source,
-				token->data,
-				title
-			);
+			char* attribute = copy_attribute(tree, token);
+			char* attribute_state;
+			const char* source = strtok_r(attribute, "\0", &attribute_state);
+			sink_write_literal(sink, "<img src=\"");
+			write_attribute_value(sink, source);
+			sink_write_literal(sink, "\" alt=\"");
+			write_data_escaped(sink, tree, token, ESCAPE_ATTRIBUTE); // The description is the value of `alt`
+			free(attribute);
+			return 1;
 		}
 		case -AUDIO: {
-			const char* source = strtok(token->attribute, "\0");
-			const char* title = strtok(NULL, "\0");
-			const char* type = strtok(NULL, "\0");
-			return format_data_buffer(
-				"<audio controls title=\"%s\">\n<source src=\"%s\" type=\"audio/%s\">\n%s\n</audio>\n",
-				title,
-				source,
-				type,
-				token->data
-			);
+			char* attribute = copy_attribute(tree, token);
+			char* attribute_state;
+			const char* source = strtok_r(attribute, "\0", &attribute_state);
+			const char* title = strtok_r(NULL, "\0", &attribute_state);
+			const char* type = strtok_r(NULL, "\0", &attribute_state);
+			sink_write_literal(sink, "<audio controls title=\"");
+			write_attribute_value(sink, title);
+			sink_write_literal(sink, "\">\n<source src=\"");
+			write_attribute_value(sink, source);
+			sink_write_literal(sink, "\" type=\"audio/");
+			write_attribute_value(sink, type);
+			sink_write_literal(sink, "\">\n");
+			write_data(sink, tree, token);
+			free(attribute);
+			return 1;
 		}
 		case -VIDEO: {
-			const char* source = strtok(token->attribute, "\0");
-			const char* title = strtok(NULL, "\0");
-			const char* type = strtok(NULL, "\0");
-			return format_data_buffer(
-				"<video title=\"%s\">\n<source src=\"%s\" type=\"video/%s\">\n%s\n</video>\n",
-				title,
-				source,
-				type,
-				token->data
-			);
+			char* attribute = copy_attribute(tree, token);
+			char* attribute_state;
+			const char* source = strtok_r(attribute, "\0", &attribute_state);
+			const char* title = strtok_r(NULL, "\0", &attribute_state);
+			const char* type = strtok_r(NULL, "\0", &attribute_state);
+			sink_write_literal(sink, "<video title=\"");
+			write_attribute_value(sink, title);
+			sink_write_literal(sink, "\">\n<source src=\"");
+			write_attribute_value(sink, source);
+			sink_write_literal(sink, "\" type=\"video/");
+			write_attribute_value(sink, type);
+			sink_write_literal(sink, "\">\n");
+			write_data(sink, tree, token);
+			free(attribute);
+			return 1;
 		}
 		case -TOP_TITLED_TABLE:
 		case -LEFT_TITLED_TABLE:
 		case -TWO_WAY_TABLE:
-			fprintf(stdout, "<!-- UNKNOWN TOKEN -->\n");
-			return NULL;
+			sink_write_literal(sink, "<!-- UNKNOWN TOKEN -->\n");
+			return 0;
 		case -INFOBOX_TITLE:
 			/* if (!token->attribute) {
 				token->attribute = generate_identifier_base(token->data);
@@ -382,18 +438,8 @@ char *parse_token(Token *token, IdentifierArray* heading_identifier_array, Ident
 		case -INFOBOX_CONTENT:
 		case -FOOTNOTE_NOTE:
 		case -ENDNOTE_NOTE:
-			fprintf(stdout, "<!-- UNKNOWN TOKEN -->\n");
-			return NULL;
-		case -PARAGRAPH:
-			return format_data_buffer(
-				"<p>%s</p>\n",
-				token->data
-			);
-		case -INDENTED_PARAGRAPH:
-			return format_data_buffer(
-				"<p class=\"indented\">%s</p>\n",
-				token->data
-			);
+			sink_write_literal(sink, "<!-- UNKNOWN TOKEN -->\n");
+			return 0;
 		case -VARIABLE_DEFINITION:
 		case -VARIABLE_RETURN:
 		case -FUNCTION_DEFINITION:
@@ -402,47 +448,91 @@ char *parse_token(Token *token, IdentifierArray* heading_identifier_array, Ident
 		case -BUILT_IN_VARIABLE_RETURN:
 		case -BUILT_IN_FUNCTION_RETURN:
 		default:
-			fprintf(stdout, "<!-- UNKNOWN TOKEN -->\n");
-			return NULL;
+			sink_write_literal(sink, "<!-- UNKNOWN TOKEN -->\n");
+			return 0;
 	}
-	
-	delete_token(&token);
 }
 
-static char *parse_recursive(Token *token, IdentifierArray* heading_identifier_array, IdentifierArray* other_identifier_array) {
-	if (token->data == NULL) {
-		token->data = malloc(1);
-		if (token->data == NULL) {
-			printf("ERROR: Memory allocation failed\n");
-			exit(1);
-		}
-		token->data[0] = '\0';
+/**
+ * @brief Writes everything which follows the children of a token opened by `open_token()`
+ */
+static void close_token(ParseState *state, TokenId token) {
+	TokenTree *tree = state->tree;
+	OutputSink *sink = current_sink(state);
+
+	TokenType type = tree->tokens.type[token];
+	if ((size_t)-type < TAG_TABLE_SIZE && tag_table[-type].open) {
+		const TagFragments *tags = &tag_table[-type];
+		sink_write(sink, tags->close, tags->close_length);
+		return;
 	}
-	
-	for (size_t i = 0; i < token->num_children; ++i) {
-		char *data = parse_recursive(token->children[i], heading_identifier_array, other_identifier_array);
-		token->data = realloc(token->data, strlen(token->data) + strlen(data) + 1);
 
-		if (token->data == NULL) {
-			fprintf(stderr, "ERROR: Memory allocation failed\n");
-			exit(1);
+	switch ((int)type) {
+		case -HEADING:
+			close_heading(state, token);
+			break;
+		case -LINK:
+			sink_write_literal(sink, "</a>\n");
+			break;
+		case -IMAGE: {
+			char* attribute = copy_attribute(tree, token);
+			char* attribute_state;
+			strtok_r(attribute, "\0", &attribute_state); // The source was written when the token was opened
+			const char* title = strtok_r(NULL, "\0", &attribute_state);
+			sink_write_literal(sink, "\" title=\"");
+			write_attribute_value(sink, title);
+			sink_write_literal(sink, "\">\n");
+			free(attribute);
+			break;
 		}
-
-		strcat(token->data, data);
+		case -AUDIO:
+			sink_write_literal(sink, "\n</audio>\n");
+			break;
+		case -VIDEO:
+			sink_write_literal(sink, "\n</video>\n");
+			break;
+		default:
+			break;
 	}
+}
 
-	print_token("", token);
+int parse_tree(TokenTree *tree, IdentifierArray* heading_identifier_array, IdentifierArray* other_identifier_array, OutputSink *sink) {
+	ParseState state = {tree, heading_identifier_array, other_identifier_array, NULL, 0, 0};
+	push_sink(&state, sink);
+
+	// The tree is walked through its parent and sibling links rather than the C stack, so that untrusted
+	// documents cannot exhaust it; the depth is only counted to enforce the limit
+	int result = 0;
+	TokenId token = 0; // The root
+	unsigned int depth = 0;
+	for (;;) {
+		if (open_token(&state, token)) {
+			if (tree->tokens.first_child[token] != NO_TOKEN) {
+				if (depth == tree->max_depth) {
+					result = -1;
+					break;
+				}
+				token = tree->tokens.first_child[token];
+				++depth;
+				continue;
+			}
+			close_token(&state, token);
+		}
 
-	delete_children(&token);
+		while (token != 0 && tree->tokens.next_sibling[token] == NO_TOKEN) {
+			token = tree->tokens.parent[token];
+			--depth;
+			close_token(&state, token);
+		}
+		if (token == 0) {
+			break;
+		}
+		token = tree->tokens.next_sibling[token];
+	}
 
-	mark_raw(token);
-	return parse_token(token, heading_identifier_array, other_identifier_array);
+	while (state.sink_count > 1) { // Only left open by a failed parse
+		free_sink(state.sinks[--state.sink_count]);
+	}
+	free(state.sinks);
+	return result;
 }
-
-int parse_tree(Token *root_token, IdentifierArray* heading_identifier_array, IdentifierArray* other_identifier_array, FILE *output_file) {
-	parse_recursive(root_token, heading_identifier_array, other_identifier_array);
-	fwrite(root_token->data, sizeof(char), strlen(root_token->data), output_file);
-	free(root_token->data);
-	free(root_token);
-	return 0;
-}
\ No newline at end of file
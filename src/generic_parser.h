@@ -3,8 +3,20 @@
 
 #include "docmark_token.h"
 #include "identifier_array.h"
-#include <stdio.h>
+#include "output_sink.h"
 
-int parse_tree(Token *root_token, IdentifierArray* heading_identifier_array, IdentifierArray* other_identifier_array, FILE *output_file);
+/**
+ * @brief Writes the HTML for a token tree, starting from its root
+ * 
+ * The tree is walked iteratively; parsing fails if tokens nest beyond the
+ * tree's `max_depth`, leaving the HTML incomplete.
+ * 
+ * @param tree The lexed tree, which should be in pre-order (see `order_token_tree()`)
+ * @param heading_identifier_array The identifiers of the document's headings
+ * @param other_identifier_array The document's other identifiers
+ * @param sink The sink to which the HTML is written, which may borrow the tokens' text until it is flushed
+ * @return int (0 on success, -1 on failure)
+ */
+int parse_tree(TokenTree *tree, IdentifierArray* heading_identifier_array, IdentifierArray* other_identifier_array, OutputSink *sink);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "html_escape.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ESCAPE_HAS_X86 1
+#include <immintrin.h>
+#endif
+
+typedef struct Entity {
+	const char *text;
+	size_t length;
+} Entity;
+
+#define ENTITY(text) {text, sizeof(text) - 1}
+
+static const Entity entities[256] = {
+	['&'] = ENTITY("&amp;"),
+	['<'] = ENTITY("&lt;"),
+	['>'] = ENTITY("&gt;"),
+	['"'] = ENTITY("&quot;"),
+	['\''] = ENTITY("&#39;"),
+};
+
+#define TEXT_SPECIAL 1
+#define ATTRIBUTE_SPECIAL 2
+
+/**
+ * @brief The modes in which each character must be escaped, as a mask of the flags above
+ */
+static const unsigned char special_table[256] = {
+	['&'] = TEXT_SPECIAL | ATTRIBUTE_SPECIAL,
+	['<'] = TEXT_SPECIAL | ATTRIBUTE_SPECIAL,
+	['>'] = TEXT_SPECIAL | ATTRIBUTE_SPECIAL,
+	['"'] = ATTRIBUTE_SPECIAL,
+	['\''] = ATTRIBUTE_SPECIAL,
+};
+
+static size_t scan_scalar(const char *data, size_t length, EscapeMode mode) {
+	unsigned char flag = (mode == ESCAPE_ATTRIBUTE) ? ATTRIBUTE_SPECIAL : TEXT_SPECIAL;
+	for (size_t i = 0; i < length; ++i) {
+		if (special_table[(unsigned char)data[i]] & flag) {
+			return i;
+		}
+	}
+	return length;
+}
+
+#ifdef ESCAPE_HAS_X86
+static size_t scan_sse2(const char *data, size_t length, EscapeMode mode) {
+	const __m128i ampersand = _mm_set1_epi8('&');
+	const __m128i less_than = _mm_set1_epi8('<');
+	const __m128i greater_than = _mm_set1_epi8('>');
+	const __m128i double_quote = _mm_set1_epi8('"');
+	const __m128i single_quote = _mm_set1_epi8('\'');
+
+	size_t i = 0;
+	for (; i + 16 <= length; i += 16) {
+		__m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+		__m128i matches = _mm_or_si128(
+			_mm_cmpeq_epi8(block, ampersand),
+			_mm_or_si128(_mm_cmpeq_epi8(block, less_than), _mm_cmpeq_epi8(block, greater_than))
+		);
+		if (mode == ESCAPE_ATTRIBUTE) {
+			matches = _mm_or_si128(
+				matches,
+				_mm_or_si128(_mm_cmpeq_epi8(block, double_quote), _mm_cmpeq_epi8(block, single_quote))
+			);
+		}
+
+		int mask = _mm_movemask_epi8(matches);
+		if (mask != 0) {
+			return i + __builtin_ctz(mask);
+		}
+	}
+	return i + scan_scalar(data + i, length - i, mode);
+}
+
+__attribute__((target("avx2")))
+static size_t scan_avx2(const char *data, size_t length, EscapeMode mode) {
+	const __m256i ampersand = _mm256_set1_epi8('&');
+	const __m256i less_than = _mm256_set1_epi8('<');
+	const __m256i greater_than = _mm256_set1_epi8('>');
+	const __m256i double_quote = _mm256_set1_epi8('"');
+	const __m256i single_quote = _mm256_set1_epi8('\'');
+
+	size_t i = 0;
+	for (; i + 32 <= length; i += 32) {
+		__m256i block = _mm256_loadu_si256((const __m256i *)(data + i));
+		__m256i matches = _mm256_or_si256(
+			_mm256_cmpeq_epi8(block, ampersand),
+			_mm256_or_si256(_mm256_cmpeq_epi8(block, less_than), _mm256_cmpeq_epi8(block, greater_than))
+		);
+		if (mode == ESCAPE_ATTRIBUTE) {
+			matches = _mm256_or_si256(
+				matches,
+				_mm256_or_si256(_mm256_cmpeq_epi8(block, double_quote), _mm256_cmpeq_epi8(block, single_quote))
+			);
+		}
+
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(matches);
+		if (mask != 0) {
+			return i + __builtin_ctz(mask);
+		}
+	}
+	// The compiler may call the SSE2 scanner without clearing the upper halves of the registers first, after which
+	// every legacy SSE instruction (there and in the rest of the program) pays for the transition between the two
+	_mm256_zeroupper();
+	return i + scan_sse2(data + i, length - i, mode); // At most one 16-byte block remains for SSE2
+}
+#endif
+
+static EscapeScanner scanners[3];
+static size_t scanner_count = 0;
+static EscapeScanFunction scan = scan_scalar;
+static pthread_once_t scanners_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Lists the scanners supported by the processor and selects the fastest of them
+ */
+static void init_scanners() {
+	scanners[scanner_count++] = (EscapeScanner){"scalar", scan_scalar};
+#ifdef ESCAPE_HAS_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2")) {
+		scanners[scanner_count++] = (EscapeScanner){"sse2", scan_sse2};
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		scanners[scanner_count++] = (EscapeScanner){"avx2", scan_avx2};
+	}
+#endif
+	scan = scanners[scanner_count - 1].scan;
+}
+
+size_t get_escape_scanners(const EscapeScanner **list) {
+	pthread_once(&scanners_once, init_scanners);
+	*list = scanners;
+	return scanner_count;
+}
+
+static void write_escaped(OutputSink *sink, const char *data, size_t length, EscapeMode mode, int is_borrowed) {
+	pthread_once(&scanners_once, init_scanners);
+
+	while (length > 0) {
+		size_t clean_length = scan(data, length, mode);
+		if (clean_length > 0) {
+			if (is_borrowed) {
+				sink_write_borrowed(sink, data, clean_length);
+			} else {
+				sink_write(sink, data, clean_length);
+			}
+		}
+		if (clean_length == length) {
+			return;
+		}
+
+		const Entity *entity = &entities[(unsigned char)data[clean_length]];
+		sink_write(sink, entity->text, entity->length);
+		data += clean_length + 1;
+		length -= clean_length + 1;
+	}
+}
+
+void sink_write_escaped(OutputSink *sink, const char *data, size_t length, EscapeMode mode) {
+	write_escaped(sink, data, length, mode, 0);
+}
+
+void sink_write_escaped_borrowed(OutputSink *sink, const char *data, size_t length, EscapeMode mode) {
+	write_escaped(sink, data, length, mode, 1);
+}
+
+void sink_puts_escaped(OutputSink *sink, const char *string, EscapeMode mode) {
+	write_escaped(sink, string, strlen(string), mode, 0);
+}
@@ -0,0 +1,56 @@
+#ifndef HTML_ESCAPE_H
+#define HTML_ESCAPE_H
+
+#include "output_sink.h"
+
+#include <stdlib.h>
+
+typedef enum EscapeMode {
+	ESCAPE_TEXT, // `&`, `<` and `>`
+	ESCAPE_ATTRIBUTE, // Also `"` and `'`, for quoted attribute values
+} EscapeMode;
+
+/**
+ * @brief Finds the first character which must be escaped
+ *
+ * @param data The data to be scanned
+ * @param length The number of bytes to be scanned
+ * @param mode The set of characters which must be escaped
+ * @return size_t The index of the first such character (`length` if there is none)
+ */
+typedef size_t (*EscapeScanFunction)(const char *data, size_t length, EscapeMode mode);
+
+typedef struct EscapeScanner {
+	const char *name;
+	EscapeScanFunction scan;
+} EscapeScanner;
+
+/**
+ * @brief Lists the scanners the processor supports, from the slowest to the one used by default
+ *
+ * @param scanners Set to the list of scanners
+ * @return size_t The number of scanners
+ */
+size_t get_escape_scanners(const EscapeScanner **scanners);
+
+/**
+ * @brief Writes data to a sink, replacing the characters of the given mode with character references
+ *
+ * Runs without special characters are found a vector at a time and written
+ * with a single copy, so clean text costs little more than `sink_write()`.
+ *
+ * @param sink The sink to be written to
+ * @param data The data to be escaped
+ * @param length The number of bytes to be escaped
+ * @param mode The set of characters to be escaped
+ */
+void sink_write_escaped(OutputSink *sink, const char *data, size_t length, EscapeMode mode);
+
+/**
+ * @brief Like `sink_write_escaped()`, but lets the sink borrow clean runs (see `sink_write_borrowed()`)
+ */
+void sink_write_escaped_borrowed(OutputSink *sink, const char *data, size_t length, EscapeMode mode);
+
+void sink_puts_escaped(OutputSink *sink, const char *string, EscapeMode mode);
+
+#endif
\ No newline at end of file
@@ -1,9 +1,12 @@
 #include "identifier_array.h"
 
 #include <ctype.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
+#define INITIAL_SLOT_COUNT 64 // Must be a power of two
+
 IdentifierArray* create_identifier_array() {
 	IdentifierArray* identifier_array = (IdentifierArray*)malloc(sizeof(IdentifierArray));
 	if (identifier_array == NULL) {
@@ -11,25 +14,98 @@ IdentifierArray* create_identifier_array() {
 		exit(1);
 	}
 	identifier_array->identifiers = NULL;
+	identifier_array->next_suffixes = NULL;
 	identifier_array->count = 0;
+	identifier_array->capacity = 0;
+	identifier_array->slots = NULL;
+	identifier_array->slot_count = 0;
 	return identifier_array;
 }
 
-void add_identifier(IdentifierArray* identifier_array, const char* id) {
-	identifier_array->identifiers = (char**)realloc(identifier_array->identifiers, (identifier_array->count + 1) * sizeof(char*));
-	if (identifier_array->identifiers == NULL) {
+static uint64_t hash_identifier(const char* id) { // FNV-1a
+	uint64_t hash = 14695981039346656037ULL;
+	while (*id) {
+		hash ^= (unsigned char)*id++;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+/**
+ * @brief Finds the slot holding an identifier, or the empty slot where it belongs
+ */
+static size_t find_slot(IdentifierArray* identifier_array, const char* id) {
+	size_t mask = identifier_array->slot_count - 1;
+	size_t slot = hash_identifier(id) & mask;
+	while (identifier_array->slots[slot] != 0) {
+		if (!strcmp(identifier_array->identifiers[identifier_array->slots[slot] - 1], id)) {
+			break;
+		}
+		slot = (slot + 1) & mask; // Linear probing
+	}
+	return slot;
+}
+
+/**
+ * @brief Doubles the number of slots, keeping the load factor at most one half
+ */
+static void grow_slots(IdentifierArray* identifier_array) {
+	free(identifier_array->slots);
+	identifier_array->slot_count = (identifier_array->slot_count == 0) ? INITIAL_SLOT_COUNT : identifier_array->slot_count * 2;
+	identifier_array->slots = (size_t*)calloc(identifier_array->slot_count, sizeof(size_t));
+	if (identifier_array->slots == NULL) {
 		fprintf(stderr, "ERROR: Memory allocation failed\n");
 		exit(1);
 	}
 
+	for (size_t i = 0; i < identifier_array->count; i++) {
+		identifier_array->slots[find_slot(identifier_array, identifier_array->identifiers[i])] = i + 1;
+	}
+}
+
+void add_identifier(IdentifierArray* identifier_array, const char* id) {
+	if (identifier_array->count == identifier_array->capacity) { // Storage is kept across resets
+		identifier_array->capacity = (identifier_array->capacity == 0) ? 16 : identifier_array->capacity * 2;
+		identifier_array->identifiers = (char**)realloc(identifier_array->identifiers, identifier_array->capacity * sizeof(char*));
+		identifier_array->next_suffixes = (unsigned int*)realloc(identifier_array->next_suffixes, identifier_array->capacity * sizeof(unsigned int));
+		if (identifier_array->identifiers == NULL || identifier_array->next_suffixes == NULL) {
+			fprintf(stderr, "ERROR: Memory allocation failed\n");
+			exit(1);
+		}
+	}
+	if ((identifier_array->count + 1) * 2 > identifier_array->slot_count) {
+		grow_slots(identifier_array);
+	}
+
 	identifier_array->identifiers[identifier_array->count] = strdup(id);
 	if (identifier_array->identifiers[identifier_array->count] == NULL) {
 		fprintf(stderr, "ERROR: Memory allocation failed\n");
 		exit(1);
 	}
+	identifier_array->next_suffixes[identifier_array->count] = 1;
+	identifier_array->slots[find_slot(identifier_array, id)] = identifier_array->count + 1;
 	identifier_array->count++;
 }
 
+size_t find_identifier(IdentifierArray* identifier_array, const char* id) {
+	if (identifier_array->count == 0) {
+		return IDENTIFIER_NOT_FOUND;
+	}
+
+	size_t slot = identifier_array->slots[find_slot(identifier_array, id)];
+	return (slot == 0) ? IDENTIFIER_NOT_FOUND : slot - 1;
+}
+
+void reset_identifier_array(IdentifierArray* identifier_array) {
+	for (size_t i = 0; i < identifier_array->count; i++) {
+		free(identifier_array->identifiers[i]);
+	}
+	if (identifier_array->count > 0) {
+		memset(identifier_array->slots, 0, identifier_array->slot_count * sizeof(size_t));
+	}
+	identifier_array->count = 0;
+}
+
 void free_identifier_array(IdentifierArray* identifier_array) {
 	if (identifier_array == NULL)
 		return;
@@ -38,5 +114,7 @@ void free_identifier_array(IdentifierArray* identifier_array) {
 		free(identifier_array->identifiers[i]);
 	}
 	free(identifier_array->identifiers);
+	free(identifier_array->next_suffixes);
+	free(identifier_array->slots);
 	free(identifier_array);
 }
@@ -3,15 +3,36 @@
 
 #include <stdlib.h>
 
+#define IDENTIFIER_NOT_FOUND ((size_t)-1)
+
+/**
+ * @brief Identifiers in the order they were added, indexed by an open-addressing hash set
+ */
 typedef struct IdentifierArray {
 	char** identifiers;
+	unsigned int* next_suffixes; // Per identifier, the first `-N` suffix not yet known to be taken when it is used as a base
 	size_t count;
+	size_t capacity;
+
+	size_t* slots; // Index + 1 of the identifier hashed to each slot (0 if the slot is empty)
+	size_t slot_count;
 } IdentifierArray;
 
 IdentifierArray* create_identifier_array();
 
 void add_identifier(IdentifierArray* identifier_array, const char* id);
 
+/**
+ * @brief Looks up an identifier in expected constant time
+ * 
+ * @param identifier_array The array to be searched
+ * @param id The identifier to be found
+ * @return size_t The index of the identifier (`IDENTIFIER_NOT_FOUND` if it is not present)
+ */
+size_t find_identifier(IdentifierArray* identifier_array, const char* id);
+
+void reset_identifier_array(IdentifierArray* identifier_array);
+
 void free_identifier_array(IdentifierArray* identifier_array);
 
 #endif
\ No newline at end of file
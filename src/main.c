@@ -1,53 +1,477 @@
+#include "arena.h"
+#include "docmark_compiler.h"
+#include "docmark_debug.h"
+#include "docmark_definitions.h"
+#include "docmark_stats.h"
 #include "docmark_token.h"
-#include "docmark_lexer.h"
-#include "generic_parser.h"
 #include "identifier_array.h"
+#include "thread_pool.h"
 
+#include <errno.h>
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-const char *output_file_path = "test/out.html";
+typedef struct InputList {
+	char **paths;
+	size_t count;
+	size_t capacity;
+} InputList;
+
+typedef struct CompileJob {
+	const char *input_path;
+	char *output_path;
+	off_t size;
+	int status;
+} CompileJob;
+
+typedef struct CompileContext {
+	CompileJob *jobs;
+	IdentifierArray **heading_identifier_arrays; // One per worker
+	IdentifierArray **other_identifier_arrays;
+	Arena **arenas;
+	TokenTree **token_trees;
+	DocmarkStats **stats; // NULL unless `--stats` was given
+} CompileContext;
+
+static void add_input(InputList *inputs, const char *path) {
+	if (inputs->count == inputs->capacity) {
+		inputs->capacity = (inputs->capacity == 0) ? 16 : inputs->capacity * 2;
+		inputs->paths = (char **)realloc(inputs->paths, inputs->capacity * sizeof(char *));
+		if (inputs->paths == NULL) {
+			fprintf(stderr, "ERROR: Memory allocation failed\n");
+			exit(1);
+		}
+	}
+
+	inputs->paths[inputs->count] = strdup(path);
+	if (inputs->paths[inputs->count] == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	++inputs->count;
+}
+
+/**
+ * @brief Adds every non-empty line of a list file as an input path
+ * 
+ * @param inputs The list to be appended to
+ * @param list_path The list file, or "-" for standard input
+ * @return int (0 on success, -1 on failure)
+ */
+static int read_input_list(InputList *inputs, const char *list_path) {
+	FILE *list_file = strcmp(list_path, "-") ? fopen(list_path, "r") : stdin;
+	if (!list_file) {
+		fprintf(stderr, "Error opening input list: %s\n", list_path);
+		return -1;
+	}
+
+	char *line = NULL;
+	size_t line_size = 0;
+	ssize_t length;
+	while ((length = getline(&line, &line_size, list_file)) >= 0) {
+		while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+			line[--length] = '\0';
+		}
+		if (length > 0) {
+			add_input(inputs, line);
+		}
+	}
+
+	free(line);
+	if (list_file != stdin) {
+		fclose(list_file);
+	}
+	return 0;
+}
+
+/**
+ * @brief Measures a path without the extension of its last component, if it has one
+ */
+static size_t path_stem_length(const char *path) {
+	const char *extension = strrchr(path, '.');
+	if (extension && !strchr(extension, '/')) {
+		return extension - path;
+	}
+	return strlen(path);
+}
+
+/**
+ * @brief Names the output of a document compiled without an output directory: beside the input with its
+ * extension replaced by `.html`, or standard output ("-") for standard input
+ *
+ * @return char* The output path (NULL if it would overwrite the input)
+ */
+static char *make_sibling_output_path(const char *input_path) {
+	if (strcmp(input_path, "-") == 0) {
+		char *output_path = strdup("-");
+		if (output_path == NULL) {
+			fprintf(stderr, "ERROR: Memory allocation failed\n");
+			exit(1);
+		}
+		return output_path;
+	}
+
+	size_t stem_length = path_stem_length(input_path);
+	size_t size = stem_length + sizeof(".html");
+	char *output_path = (char *)malloc(size);
+	if (output_path == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	snprintf(output_path, size, "%.*s.html", (int)stem_length, input_path);
+	if (strcmp(output_path, input_path) == 0) {
+		free(output_path);
+		return NULL;
+	}
+	return output_path;
+}
+
+/**
+ * @brief Mirrors an input path under the output directory, replacing its extension with `.html`
+ * 
+ * @return char* The output path (NULL if the input path leaves its directory)
+ */
+static char *make_output_path(const char *output_directory, const char *input_path) {
+	if (strcmp(input_path, "-") == 0) {
+		input_path = "stdin";
+	}
+
+	while (*input_path == '/' || (input_path[0] == '.' && input_path[1] == '/')) {
+		input_path += (*input_path == '/') ? 1 : 2;
+	}
+
+	for (const char *component = input_path; component; component = strchr(component, '/')) {
+		if (*component == '/') {
+			++component;
+		}
+		if (component[0] == '.' && component[1] == '.' && (component[2] == '/' || component[2] == '\0')) {
+			return NULL;
+		}
+	}
+
+	size_t stem_length = path_stem_length(input_path);
+	size_t size = strlen(output_directory) + 1 + stem_length + sizeof(".html");
+	char *output_path = (char *)malloc(size);
+	if (output_path == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	snprintf(output_path, size, "%s/%.*s.html", output_directory, (int)stem_length, input_path);
+	return output_path;
+}
+
+/**
+ * @brief Creates every missing parent directory of a path
+ * 
+ * @return int (0 on success, -1 on failure)
+ */
+static int make_parent_directories(char *path) {
+	for (char *separator = strchr(path + 1, '/'); separator; separator = strchr(separator + 1, '/')) {
+		*separator = '\0';
+		int result = mkdir(path, 0777);
+		*separator = '/';
+		if (result != 0 && errno != EEXIST) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Names the file which an output path refers to by the device and inode of its directory and its own
+ * name, so that paths spelt differently (`out/a.html` and `out/./a.html`) are named alike
+ *
+ * @return char* The name (NULL if the directory does not exist)
+ */
+static char *make_output_key(const char *output_path) {
+	if (strcmp(output_path, "-") == 0) {
+		return strdup(output_path);
+	}
+
+	const char *separator = strrchr(output_path, '/');
+	char *directory = separator ? strndup(output_path, separator - output_path + 1) : strdup(".");
+	if (directory == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	struct stat directory_status;
+	int result = stat(directory, &directory_status);
+	free(directory);
+	if (result != 0) {
+		return NULL;
+	}
+
+	const char *name = separator ? separator + 1 : output_path;
+	size_t size = strlen(name) + 48;
+	char *output_key = (char *)malloc(size);
+	if (output_key == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	snprintf(
+		output_key,
+		size,
+		"%llu:%llu/%s",
+		(unsigned long long)directory_status.st_dev,
+		(unsigned long long)directory_status.st_ino,
+		name
+	);
+	return output_key;
+}
+
+static void compile_job(size_t task_index, unsigned int worker_index, void *context) {
+	CompileContext *compile_context = (CompileContext *)context;
+	CompileJob *job = &compile_context->jobs[task_index];
+
+	job->status = compile_file(
+		job->input_path,
+		job->output_path,
+		compile_context->heading_identifier_arrays[worker_index],
+		compile_context->other_identifier_arrays[worker_index],
+		compile_context->arenas[worker_index],
+		compile_context->token_trees[worker_index],
+		compile_context->stats ? compile_context->stats[worker_index] : NULL
+	);
+}
+
+static int compare_job_size(const void *a, const void *b) {
+	off_t size_a = ((const CompileJob *)a)->size;
+	off_t size_b = ((const CompileJob *)b)->size;
+	return (size_a < size_b) - (size_a > size_b); // Largest first
+}
+
+static void print_usage(const char *program) {
+	fprintf(
+		stderr,
+		"Usage: %s [-j <threads>] [-o <output directory>] [--files-from <list>] [--huge-pages] [--max-depth=<levels>] [--stats[=text|json]] [--trace=lex,parse] <filename>...\n",
+		program
+	);
+}
+
+static int parse_thread_count(const char *argument, unsigned int *thread_count) {
+	char *end;
+	long count = strtol(argument, &end, 10);
+	if (*argument == '\0' || *end != '\0' || count < 0) {
+		return -1;
+	}
+
+	if (count == 0) { // Use every online processor
+		count = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	*thread_count = count > 0 ? (unsigned int)count : 1;
+	return 0;
+}
+
+static int parse_max_depth(const char *argument, unsigned int *max_depth) {
+	char *end;
+	errno = 0;
+	unsigned long depth = strtoul(argument, &end, 10);
+	if (*argument < '0' || *argument > '9' || *end != '\0' || errno != 0 || depth == 0 || depth > UINT_MAX) {
+		return -1;
+	}
+	*max_depth = (unsigned int)depth;
+	return 0;
+}
 
 int main(int argc, char *argv[]) {
-	if (argc != 2) {
-		fprintf(stderr, "Usage: %s <filename>\n", argv[0]);
-		return 1;
+	const char *output_directory = NULL;
+	unsigned int thread_count = 1;
+	int use_huge_pages = 0;
+	unsigned int max_depth = DEFAULT_MAX_DEPTH;
+	int collect_stats = 0;
+	StatsFormat stats_format = STATS_TEXT;
+	StatsClock run_clock;
+	start_stats_clock(&run_clock);
+	InputList inputs = {NULL, 0, 0};
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			output_directory = argv[++i];
+		} else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+			if (parse_thread_count(argv[++i], &thread_count) != 0) {
+				print_usage(argv[0]);
+				return 1;
+			}
+		} else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2] != '\0') {
+			if (parse_thread_count(argv[i] + 2, &thread_count) != 0) {
+				print_usage(argv[0]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--files-from") == 0 && i + 1 < argc) {
+			if (read_input_list(&inputs, argv[++i]) != 0) {
+				return 1;
+			}
+		} else if (strncmp(argv[i], "--files-from=", 13) == 0) {
+			if (read_input_list(&inputs, argv[i] + 13) != 0) {
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--huge-pages") == 0) {
+			use_huge_pages = 1;
+		} else if (strncmp(argv[i], "--max-depth=", 12) == 0) {
+			if (parse_max_depth(argv[i] + 12, &max_depth) != 0) {
+				print_usage(argv[0]);
+				return 1;
+			}
+		} else if (strcmp(argv[i], "--stats") == 0) {
+			collect_stats = 1;
+		} else if (strncmp(argv[i], "--stats=", 8) == 0) {
+			if (parse_stats_format(argv[i] + 8, &stats_format) != 0) {
+				print_usage(argv[0]);
+				return 1;
+			}
+			collect_stats = 1;
+		} else if (strncmp(argv[i], "--trace=", 8) == 0) {
+			if (set_trace_categories(argv[i] + 8) != 0) {
+				return 1;
+			}
+		} else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+			print_usage(argv[0]);
+			return 1;
+		} else {
+			add_input(&inputs, argv[i]);
+		}
 	}
 
-	FILE *input_file = fopen(argv[1], "r");
-	if (!input_file) {
-		fprintf(stderr, "Error opening input file");
+	if (inputs.count == 0 || (inputs.count > 1 && !output_directory)) {
+		print_usage(argv[0]);
 		return 1;
 	}
 
-	FILE *output_file = fopen(output_file_path, "w");
-	if (!input_file) {
-		fprintf(stderr, "Error opening output file");
-		return 1;
+	int status = 0;
+	size_t job_count = 0;
+	CompileJob *jobs = (CompileJob *)malloc(inputs.count * sizeof(CompileJob));
+	if (jobs == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
 	}
 
-	fseek(input_file, 0, SEEK_END);
-	long size = ftell(input_file);
-	fseek(input_file, 0, SEEK_SET);
+	// Outputs already claimed by an input, so that no two jobs race to replace the same file
+	IdentifierArray *output_keys = create_identifier_array();
+	for (size_t i = 0; i < inputs.count; ++i) {
+		CompileJob *job = &jobs[job_count];
+		job->input_path = inputs.paths[i];
+		job->status = 0;
 
-	char *input_file_content = (char *)malloc(size + 2); // Allocate additional space for a trailing newline character
-	if (input_file_content == NULL) {
-		fprintf(stderr, "Memory allocation error");
-		fclose(input_file);
-		return 1;
+		if (!output_directory) {
+			job->output_path = make_sibling_output_path(inputs.paths[i]);
+			if (!job->output_path) {
+				fprintf(stderr, "Error: Output would overwrite its input: %s\n", inputs.paths[i]);
+				status = 1;
+				continue;
+			}
+		} else {
+			job->output_path = make_output_path(output_directory, inputs.paths[i]);
+			if (!job->output_path) {
+				fprintf(stderr, "Error: Input path leaves its directory: %s\n", inputs.paths[i]);
+				status = 1;
+				continue;
+			}
+
+			if (make_parent_directories(job->output_path) != 0) {
+				fprintf(stderr, "Error creating output directory for: %s\n", job->output_path);
+				free(job->output_path);
+				status = 1;
+				continue;
+			}
+		}
+
+		char *output_key = make_output_key(job->output_path);
+		if (output_key && find_identifier(output_keys, output_key) != IDENTIFIER_NOT_FOUND) {
+			fprintf(stderr, "Error: Output would be written by more than one input: %s (from %s)\n", job->output_path, job->input_path);
+			free(output_key);
+			free(job->output_path);
+			status = 1;
+			continue;
+		}
+		if (output_key) {
+			add_identifier(output_keys, output_key);
+			free(output_key);
+		}
+
+		struct stat input_status;
+		job->size = (stat(job->input_path, &input_status) == 0) ? input_status.st_size : 0;
+		++job_count;
+	}
+	free_identifier_array(output_keys);
+
+	// Start the largest documents first so that a few large ones do not finish last
+	qsort(jobs, job_count, sizeof(CompileJob), compare_job_size);
+
+	if (thread_count > job_count) {
+		thread_count = job_count > 0 ? job_count : 1;
+	}
+
+	CompileContext context;
+	context.jobs = jobs;
+	context.heading_identifier_arrays = (IdentifierArray **)malloc(thread_count * sizeof(IdentifierArray *));
+	context.other_identifier_arrays = (IdentifierArray **)malloc(thread_count * sizeof(IdentifierArray *));
+	context.arenas = (Arena **)malloc(thread_count * sizeof(Arena *));
+	context.token_trees = (TokenTree **)malloc(thread_count * sizeof(TokenTree *));
+	context.stats = NULL;
+	if (collect_stats) {
+		context.stats = (DocmarkStats **)malloc(thread_count * sizeof(DocmarkStats *));
+		if (context.stats == NULL) {
+			fprintf(stderr, "ERROR: Memory allocation failed\n");
+			exit(1);
+		}
+		for (unsigned int i = 0; i < thread_count; ++i) {
+			context.stats[i] = create_stats();
+		}
+	}
+	if (
+		context.heading_identifier_arrays == NULL ||
+		context.other_identifier_arrays == NULL ||
+		context.arenas == NULL ||
+		context.token_trees == NULL
+	) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	for (unsigned int i = 0; i < thread_count; ++i) {
+		context.heading_identifier_arrays[i] = create_identifier_array();
+		context.other_identifier_arrays[i] = create_identifier_array();
+		context.arenas[i] = create_arena(use_huge_pages ? ARENA_HUGE_PAGE_SIZE : 0, use_huge_pages);
+		context.token_trees[i] = create_token_tree();
+		context.token_trees[i]->max_depth = max_depth;
 	}
 
-	fread(input_file_content, 1, size, input_file);
-	input_file_content[size] = '\n';
-	input_file_content[size + 1] = '\0';
-	fclose(input_file);
+	run_thread_pool(job_count, thread_count, compile_job, &context);
 
-	Token *root = root_token(input_file_content);
-	IdentifierArray *heading_identifier_array = create_identifier_array();
-	IdentifierArray *other_identifier_array = create_identifier_array();
+	for (size_t i = 0; i < job_count; ++i) {
+		if (jobs[i].status != 0) {
+			status = 1;
+		}
+		free(jobs[i].output_path);
+	}
+	if (context.stats) {
+		for (unsigned int i = 1; i < thread_count; ++i) {
+			merge_stats(context.stats[0], context.stats[i]);
+			free_stats(context.stats[i]);
+		}
+		print_stats(stderr, context.stats[0], &run_clock, stats_format);
+		free_stats(context.stats[0]);
+		free(context.stats);
+	}
+	for (unsigned int i = 0; i < thread_count; ++i) {
+		free_identifier_array(context.heading_identifier_arrays[i]);
+		free_identifier_array(context.other_identifier_arrays[i]);
+		free_arena(context.arenas[i]);
+		free_token_tree(context.token_trees[i]);
+	}
+	free(context.heading_identifier_arrays);
+	free(context.other_identifier_arrays);
+	free(context.arenas);
+	free(context.token_trees);
+	free(jobs);
 
-	lex_recursive(root);
-	parse_tree(root, heading_identifier_array, other_identifier_array, output_file);
+	for (size_t i = 0; i < inputs.count; ++i) {
+		free(inputs.paths[i]);
+	}
+	free(inputs.paths);
 
-	return 0;
+	return status;
 }
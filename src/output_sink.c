@@ -0,0 +1,251 @@
+#include "output_sink.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SINK_BUFFER_SIZE 65536
+#define MEMORY_SINK_INITIAL_SIZE 256
+#define SINK_MAX_FRAGMENTS 64
+#define SINK_BORROW_MIN_LENGTH 256 // Shorter writes are cheaper to copy than to queue
+
+static OutputSink *create_sink(FILE *file, int fd, size_t capacity) {
+	OutputSink *sink = (OutputSink *)malloc(sizeof(OutputSink));
+	if (sink == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+
+	sink->buffer = (char *)malloc(capacity + 1); // Reserve space for a NUL terminator
+	if (sink->buffer == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	sink->buffer[0] = '\0';
+	sink->length = 0;
+	sink->capacity = capacity;
+	sink->fragments = NULL;
+	sink->fragment_count = 0;
+	sink->fragment_start = 0;
+	sink->file = file;
+	sink->fd = fd;
+	sink->error = 0;
+	return sink;
+}
+
+OutputSink *create_file_sink(FILE *file) {
+	return create_sink(file, -1, SINK_BUFFER_SIZE);
+}
+
+OutputSink *create_fd_sink(int fd) {
+	return create_sink(NULL, fd, SINK_BUFFER_SIZE);
+}
+
+OutputSink *create_memory_sink() {
+	return create_sink(NULL, -1, MEMORY_SINK_INITIAL_SIZE);
+}
+
+static int is_memory_sink(OutputSink *sink) {
+	return sink->file == NULL && sink->fd < 0;
+}
+
+static int write_fd(int fd, const char *data, size_t length) {
+	while (length > 0) {
+		ssize_t written = write(fd, data, length);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		data += written;
+		length -= written;
+	}
+	return 0;
+}
+
+static int writev_fd(int fd, struct iovec *fragments, int count) {
+	while (count > 0) {
+		ssize_t written = writev(fd, fragments, count);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		while (count > 0 && (size_t)written >= fragments->iov_len) { // Skip the fragments written in full
+			written -= fragments->iov_len;
+			++fragments;
+			--count;
+		}
+		if (count > 0) {
+			fragments->iov_base = (char *)fragments->iov_base + written;
+			fragments->iov_len -= written;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Queues the buffered output written since the last fragment as a fragment of its own
+ */
+static void close_buffer_fragment(OutputSink *sink) {
+	if (sink->length > sink->fragment_start) {
+		sink->fragments[sink->fragment_count].iov_base = sink->buffer + sink->fragment_start;
+		sink->fragments[sink->fragment_count].iov_len = sink->length - sink->fragment_start;
+		++sink->fragment_count;
+		sink->fragment_start = sink->length;
+	}
+}
+
+int flush_sink(OutputSink *sink) {
+	if (is_memory_sink(sink) || (sink->length == 0 && sink->fragment_count == 0)) {
+		return sink->error ? -1 : 0;
+	}
+
+	if (!sink->error) {
+		if (sink->file) {
+			if (fwrite(sink->buffer, sizeof(char), sink->length, sink->file) != sink->length) {
+				sink->error = 1;
+			}
+		} else if (sink->fragment_count > 0) {
+			close_buffer_fragment(sink);
+			sink->error = writev_fd(sink->fd, sink->fragments, sink->fragment_count) != 0;
+		} else {
+			sink->error = write_fd(sink->fd, sink->buffer, sink->length) != 0;
+		}
+	}
+	sink->fragment_count = 0;
+	sink->length = 0;
+	sink->fragment_start = 0;
+	sink->buffer[0] = '\0';
+	return sink->error ? -1 : 0;
+}
+
+/**
+ * @brief Ensures that `length` more bytes fit in the buffer, flushing or growing it as needed
+ *
+ * @return int (0 on success, -1 if flushing failed)
+ */
+static int reserve_sink(OutputSink *sink, size_t length) {
+	if (sink->length + length <= sink->capacity) {
+		return 0;
+	}
+
+	if (!is_memory_sink(sink)) {
+		if (flush_sink(sink) != 0) {
+			return -1;
+		}
+		if (length <= sink->capacity) {
+			return 0;
+		}
+	}
+
+	size_t capacity = sink->capacity;
+	while (sink->length + length > capacity) {
+		capacity *= 2;
+	}
+	sink->buffer = (char *)realloc(sink->buffer, capacity + 1);
+	if (sink->buffer == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	sink->capacity = capacity;
+	return 0;
+}
+
+void sink_write(OutputSink *sink, const char *data, size_t length) {
+	if (sink->error) {
+		return;
+	}
+	if (!is_memory_sink(sink) && length > sink->capacity) { // Too large to be worth buffering
+		if (flush_sink(sink) != 0) {
+			return;
+		}
+		if (sink->file) {
+			sink->error = fwrite(data, sizeof(char), length, sink->file) != length;
+		} else {
+			sink->error = write_fd(sink->fd, data, length) != 0;
+		}
+		return;
+	}
+
+	if (reserve_sink(sink, length) != 0) {
+		return;
+	}
+	memcpy(sink->buffer + sink->length, data, length);
+	sink->length += length;
+	sink->buffer[sink->length] = '\0';
+}
+
+void sink_write_borrowed(OutputSink *sink, const char *data, size_t length) {
+	if (sink->error) {
+		return;
+	}
+	if (sink->fd < 0 || length < SINK_BORROW_MIN_LENGTH) {
+		sink_write(sink, data, length);
+		return;
+	}
+
+	if (sink->fragments == NULL) {
+		sink->fragments = (struct iovec *)malloc(SINK_MAX_FRAGMENTS * sizeof(struct iovec));
+		if (sink->fragments == NULL) {
+			fprintf(stderr, "ERROR: Memory allocation failed\n");
+			exit(1);
+		}
+	} else if (sink->fragment_count + 3 > SINK_MAX_FRAGMENTS) { // Leave room for the buffered output before and after the data
+		if (flush_sink(sink) != 0) {
+			return;
+		}
+	}
+
+	close_buffer_fragment(sink);
+	sink->fragments[sink->fragment_count].iov_base = (void *)data;
+	sink->fragments[sink->fragment_count].iov_len = length;
+	++sink->fragment_count;
+}
+
+void sink_puts(OutputSink *sink, const char *string) {
+	sink_write(sink, string, strlen(string));
+}
+
+void sink_printf(OutputSink *sink, const char *format, ...) {
+	if (sink->error) {
+		return;
+	}
+
+	va_list args;
+	va_list temp_args;
+	va_start(args, format);
+	va_copy(temp_args, args);
+
+	int size = vsnprintf(sink->buffer + sink->length, sink->capacity - sink->length + 1, format, temp_args);
+	va_end(temp_args);
+	if (size < 0) {
+		fprintf(stderr, "ERROR: Could not determine formatted string size\n");
+		exit(1);
+	}
+
+	if (sink->length + (size_t)size > sink->capacity) { // Did not fit; make room and format again
+		if (reserve_sink(sink, size) != 0) {
+			va_end(args);
+			return;
+		}
+		vsnprintf(sink->buffer + sink->length, sink->capacity - sink->length + 1, format, args);
+	}
+	va_end(args);
+	sink->length += size;
+}
+
+int free_sink(OutputSink *sink) {
+	if (sink == NULL) {
+		return 0;
+	}
+
+	int result = flush_sink(sink);
+	free(sink->buffer);
+	free(sink->fragments);
+	free(sink);
+	return result;
+}
@@ -0,0 +1,83 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/uio.h>
+
+typedef struct OutputSink {
+	char *buffer;
+	size_t length;
+	size_t capacity;
+
+	// Pending output, in order, which is written with a single `writev()` when the sink is flushed;
+	// fragments either borrow the caller's data or cover a stretch of the buffer
+	struct iovec *fragments;
+	int fragment_count;
+	size_t fragment_start; // Where the buffered output not yet covered by a fragment begins
+
+	FILE *file; // NULL unless the sink writes to a stream
+	int fd; // -1 unless the sink writes to a file descriptor
+	int error; // Set by the first failed write, after which all output is discarded
+} OutputSink;
+
+/**
+ * @brief Creates a sink which buffers output and writes it to a stream
+ *
+ * @param file The stream to be written to
+ * @return OutputSink*
+ */
+OutputSink *create_file_sink(FILE *file);
+
+/**
+ * @brief Creates a sink which buffers output and writes it to a file descriptor
+ *
+ * @param fd The file descriptor to be written to
+ * @return OutputSink*
+ */
+OutputSink *create_fd_sink(int fd);
+
+/**
+ * @brief Creates a sink which collects all output in a growing, NUL-terminated buffer
+ *
+ * @return OutputSink*
+ */
+OutputSink *create_memory_sink();
+
+void sink_write(OutputSink *sink, const char *data, size_t length);
+
+/**
+ * @brief Writes data which outlives the sink's next flush, so that large writes need not be copied
+ *
+ * Large writes to a file descriptor sink are queued by reference and gathered
+ * with the buffered output by `writev()`; anything else is copied as by `sink_write()`.
+ *
+ * @param sink The sink to be written to
+ * @param data The data to be written, which must stay valid and unchanged until the sink is flushed
+ * @param length The number of bytes to be written
+ */
+void sink_write_borrowed(OutputSink *sink, const char *data, size_t length);
+
+void sink_puts(OutputSink *sink, const char *string);
+
+#define sink_write_literal(sink, literal) sink_write(sink, literal, sizeof(literal) - 1) // Length known at compile time
+
+void sink_printf(OutputSink *sink, const char *format, ...);
+
+/**
+ * @brief Writes all buffered output of a stream or file descriptor sink
+ *
+ * @param sink The sink to be flushed
+ * @return int (0 on success, -1 if this or any earlier write failed)
+ */
+int flush_sink(OutputSink *sink);
+
+/**
+ * @brief Flushes and frees a sink; the underlying stream or file descriptor is not closed
+ *
+ * @param sink The sink to be freed
+ * @return int (0 on success, -1 if any write failed)
+ */
+int free_sink(OutputSink *sink);
+
+#endif
@@ -0,0 +1,147 @@
+#include "source_buffer.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define READ_CHUNK_SIZE 65536
+
+static void terminate_source(SourceBuffer *source) {
+	source->data[source->length++] = '\n';
+	source->data[source->length] = '\0';
+	source->data[source->length + 1] = '\0';
+}
+
+/**
+ * @brief Reads the whole of a range of a file, retrying after short reads
+ *
+ * @return int (0 on success, -1 on failure)
+ */
+static int read_range(int fd, char *data, size_t length, off_t offset) {
+	while (length > 0) {
+		ssize_t read_size = pread(fd, data, length, offset);
+		if (read_size <= 0) {
+			return -1;
+		}
+		data += read_size;
+		length -= (size_t)read_size;
+		offset += read_size;
+	}
+	return 0;
+}
+
+static SourceBuffer *map_source_buffer(int fd, size_t size) {
+	size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	size_t file_mapping_size = size / page_size * page_size; // The whole pages of the file
+	size_t mapping_size = (size + SOURCE_BUFFER_PADDING + page_size - 1) / page_size * page_size;
+
+	// Reserve the padded region first, so that the partial last page of the file and the sentinels after it
+	// are anonymous memory which can be written without copying on write
+	char *base = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED) {
+		return NULL;
+	}
+
+	if (file_mapping_size > 0 && mmap(base, file_mapping_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		munmap(base, mapping_size);
+		return NULL;
+	}
+	if (read_range(fd, base + file_mapping_size, size - file_mapping_size, (off_t)file_mapping_size) != 0) {
+		munmap(base, mapping_size);
+		return NULL;
+	}
+	madvise(base, mapping_size, MADV_SEQUENTIAL);
+
+	SourceBuffer *source = (SourceBuffer *)malloc(sizeof(SourceBuffer));
+	if (source == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	source->data = base;
+	source->length = size;
+	source->mapping_size = mapping_size;
+	source->is_mapped = 1;
+
+	terminate_source(source);
+	mprotect(base + file_mapping_size, mapping_size - file_mapping_size, PROT_READ); // So that any write faults
+	return source;
+}
+
+SourceBuffer *open_source_buffer(const char *path) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	struct stat file_status;
+	if (fstat(fd, &file_status) == 0 && S_ISREG(file_status.st_mode)) {
+		SourceBuffer *source = map_source_buffer(fd, (size_t)file_status.st_size);
+		if (source) {
+			close(fd);
+			return source;
+		}
+	}
+
+	FILE *file = fdopen(fd, "r");
+	if (file == NULL) {
+		close(fd);
+		return NULL;
+	}
+
+	SourceBuffer *source = read_source_buffer(file);
+	fclose(file);
+	return source;
+}
+
+SourceBuffer *read_source_buffer(FILE *file) {
+	SourceBuffer *source = (SourceBuffer *)malloc(sizeof(SourceBuffer));
+	if (source == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+	source->data = NULL;
+	source->length = 0;
+	source->mapping_size = 0;
+	source->is_mapped = 0;
+
+	for (;;) {
+		if (source->length + READ_CHUNK_SIZE + SOURCE_BUFFER_PADDING > source->mapping_size) {
+			source->mapping_size = (source->mapping_size == 0) ? READ_CHUNK_SIZE : source->mapping_size * 2;
+			source->data = (char *)realloc(source->data, source->mapping_size + SOURCE_BUFFER_PADDING);
+			if (source->data == NULL) {
+				fprintf(stderr, "ERROR: Memory allocation failed\n");
+				exit(1);
+			}
+		}
+
+		size_t read_size = fread(source->data + source->length, 1, READ_CHUNK_SIZE, file);
+		source->length += read_size;
+		if (read_size < READ_CHUNK_SIZE) {
+			break;
+		}
+	}
+
+	if (ferror(file)) {
+		free(source->data);
+		free(source);
+		return NULL;
+	}
+
+	terminate_source(source);
+	return source;
+}
+
+void free_source_buffer(SourceBuffer *source) {
+	if (source == NULL) {
+		return;
+	}
+
+	if (source->is_mapped) {
+		munmap(source->data, source->mapping_size);
+	} else {
+		free(source->data);
+	}
+	free(source);
+}
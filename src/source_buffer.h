@@ -0,0 +1,39 @@
+#ifndef SOURCE_BUFFER_H
+#define SOURCE_BUFFER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SOURCE_BUFFER_PADDING 3 // A trailing newline followed by two NUL sentinels
+
+typedef struct SourceBuffer {
+	char *data;
+	size_t length; // Length of the document including the trailing newline
+	size_t mapping_size;
+	int is_mapped;
+} SourceBuffer;
+
+/**
+ * @brief Opens a source document by mapping it into memory
+ *
+ * The whole pages of the file are mapped read-only, and the rest of it is read
+ * into anonymous memory after them, followed by a newline and two NUL
+ * sentinels; the buffer is then read-only throughout. Files that cannot be mapped
+ * (pipes, terminals, etc.) are read into a padded heap buffer instead.
+ *
+ * @param path The path of the document to be opened
+ * @return SourceBuffer* (NULL on failure)
+ */
+SourceBuffer *open_source_buffer(const char *path);
+
+/**
+ * @brief Reads a source document from a stream into a padded heap buffer
+ *
+ * @param file The stream to be read until end-of-file
+ * @return SourceBuffer* (NULL on failure)
+ */
+SourceBuffer *read_source_buffer(FILE *file);
+
+void free_source_buffer(SourceBuffer *source);
+
+#endif
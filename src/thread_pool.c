@@ -0,0 +1,131 @@
+#include "thread_pool.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+typedef struct WorkQueue {
+	pthread_mutex_t mutex;
+	size_t *tasks;
+	size_t front;
+	size_t back;
+} WorkQueue;
+
+typedef struct ThreadPool {
+	WorkQueue *queues;
+	unsigned int thread_count;
+	ThreadPoolTask task;
+	void *context;
+} ThreadPool;
+
+typedef struct Worker {
+	ThreadPool *pool;
+	unsigned int index;
+} Worker;
+
+static int pop_front(WorkQueue *queue, size_t *task_index) {
+	int found = 0;
+	pthread_mutex_lock(&queue->mutex);
+	if (queue->front < queue->back) {
+		*task_index = queue->tasks[queue->front++];
+		found = 1;
+	}
+	pthread_mutex_unlock(&queue->mutex);
+	return found;
+}
+
+static int steal_back(WorkQueue *queue, size_t *task_index) {
+	int found = 0;
+	pthread_mutex_lock(&queue->mutex);
+	if (queue->front < queue->back) {
+		*task_index = queue->tasks[--queue->back];
+		found = 1;
+	}
+	pthread_mutex_unlock(&queue->mutex);
+	return found;
+}
+
+static void *run_worker(void *argument) {
+	Worker *worker = (Worker *)argument;
+	ThreadPool *pool = worker->pool;
+	size_t task_index;
+
+	for (;;) {
+		if (pop_front(&pool->queues[worker->index], &task_index)) {
+			pool->task(task_index, worker->index, pool->context);
+			continue;
+		}
+
+		// No tasks are created while running, so finding every queue empty means the work is done
+		int stolen = 0;
+		for (unsigned int i = 1; i < pool->thread_count && !stolen; ++i) {
+			stolen = steal_back(&pool->queues[(worker->index + i) % pool->thread_count], &task_index);
+		}
+		if (!stolen) {
+			return NULL;
+		}
+		pool->task(task_index, worker->index, pool->context);
+	}
+}
+
+void run_thread_pool(size_t task_count, unsigned int thread_count, ThreadPoolTask task, void *context) {
+	if (thread_count == 0) {
+		thread_count = 1;
+	}
+	if (thread_count > task_count) {
+		thread_count = task_count > 0 ? task_count : 1;
+	}
+
+	if (thread_count == 1) {
+		for (size_t i = 0; i < task_count; ++i) {
+			task(i, 0, context);
+		}
+		return;
+	}
+
+	ThreadPool pool = {NULL, thread_count, task, context};
+	pool.queues = (WorkQueue *)malloc(thread_count * sizeof(WorkQueue));
+	size_t *tasks = (size_t *)malloc(task_count * sizeof(size_t));
+	Worker *workers = (Worker *)malloc(thread_count * sizeof(Worker));
+	pthread_t *threads = (pthread_t *)malloc(thread_count * sizeof(pthread_t));
+	if (pool.queues == NULL || tasks == NULL || workers == NULL || threads == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+
+	// Deal the tasks round-robin; each queue occupies a contiguous slice of `tasks`
+	size_t offset = 0;
+	for (unsigned int i = 0; i < thread_count; ++i) {
+		WorkQueue *queue = &pool.queues[i];
+		pthread_mutex_init(&queue->mutex, NULL);
+		queue->tasks = tasks + offset;
+		queue->front = 0;
+		queue->back = 0;
+		for (size_t task_index = i; task_index < task_count; task_index += thread_count) {
+			queue->tasks[queue->back++] = task_index;
+		}
+		offset += queue->back;
+
+		workers[i].pool = &pool;
+		workers[i].index = i;
+	}
+
+	unsigned int started = 1;
+	for (; started < thread_count; ++started) {
+		if (pthread_create(&threads[started], NULL, run_worker, &workers[started]) != 0) {
+			break; // The queues of workers which did not start are drained by stealing
+		}
+	}
+	run_worker(&workers[0]);
+
+	for (unsigned int i = 1; i < started; ++i) {
+		pthread_join(threads[i], NULL);
+	}
+
+	for (unsigned int i = 0; i < thread_count; ++i) {
+		pthread_mutex_destroy(&pool.queues[i].mutex);
+	}
+	free(threads);
+	free(workers);
+	free(tasks);
+	free(pool.queues);
+}
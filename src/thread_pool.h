@@ -0,0 +1,29 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdlib.h>
+
+/**
+ * @brief A unit of work run by the thread pool
+ * 
+ * @param task_index The index of the task, in [0, task_count)
+ * @param worker_index The index of the worker running the task, in [0, thread_count)
+ * @param context The context pointer given to `run_thread_pool()`
+ */
+typedef void (*ThreadPoolTask)(size_t task_index, unsigned int worker_index, void *context);
+
+/**
+ * @brief Runs every task on a pool of work-stealing threads and waits for them to finish
+ * 
+ * Tasks are dealt round-robin to per-worker queues, so tasks should be ordered from
+ * the most to the least expensive. Each worker runs its own queue from the front;
+ * a worker whose queue is empty steals from the back of another worker's queue.
+ * 
+ * @param task_count The number of tasks
+ * @param thread_count The number of workers (one runs on the calling thread)
+ * @param task The function run for each task
+ * @param context Passed to every task
+ */
+void run_thread_pool(size_t task_count, unsigned int thread_count, ThreadPoolTask task, void *context);
+
+#endif
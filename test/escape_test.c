@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "docmark_token.h"
+#include "generic_parser.h"
+#include "identifier_array.h"
+#include "output_sink.h"
+
+/**
+ * @brief A token which no input can produce yet, built directly with its data followed by its attribute
+ */
+typedef struct EscapeCase {
+	const char *description;
+	TokenType type;
+	const char *text; // The data, then the attribute (whose parts are separated by NUL)
+	size_t data_length;
+	size_t attribute_length;
+	const char *expected; // Which must appear in the output
+} EscapeCase;
+
+static const EscapeCase cases[] = {
+	{
+		"escapes a quote in an image description",
+		IMAGE,
+		"say \"cheese\"" "pic.png",
+		12,
+		7,
+		"<img src=\"pic.png\" alt=\"say &quot;cheese&quot;\"",
+	},
+	{
+		"escapes markup in an image description",
+		IMAGE,
+		"<b> & 'x'" "pic.png",
+		9,
+		7,
+		"alt=\"&lt;b&gt; &amp; &#39;x&#39;\"",
+	},
+	{
+		"escapes a quote in a link source",
+		LINK,
+		"text" "a\"b",
+		4,
+		3,
+		"<a href=\"a&quot;b\"",
+	},
+	{
+		"leaves quotes in link text alone",
+		LINK,
+		"\"text\"" "page.html",
+		6,
+		9,
+		"\">\"text\"</a>",
+	},
+};
+
+static int render_case(const EscapeCase *escape_case) {
+	TokenTree *tree = create_token_tree();
+	TokenId root = root_token(tree, "\0", 0); // Empty, so that only the case is written
+	TokenId token = add_child(
+		tree,
+		escape_case->type,
+		escape_case->text,
+		(Span){0, (unsigned int)escape_case->data_length},
+		(Span){(unsigned int)escape_case->data_length, (unsigned int)escape_case->attribute_length},
+		0,
+		root
+	);
+	mark_raw(tree, token);
+	mark_raw(tree, root);
+
+	IdentifierArray *heading_identifier_array = create_identifier_array();
+	IdentifierArray *other_identifier_array = create_identifier_array();
+	OutputSink *sink = create_memory_sink();
+	order_token_tree(tree);
+	int ok = parse_tree(tree, heading_identifier_array, other_identifier_array, sink) == 0 &&
+		strstr(sink->buffer, escape_case->expected) != NULL;
+
+	printf("  %-60s %s\n", escape_case->description, ok ? "ok" : "FAILED");
+	if (!ok) {
+		printf("    expected: %s\n    rendered: %s\n", escape_case->expected, sink->buffer);
+	}
+	free_sink(sink);
+	free_identifier_array(heading_identifier_array);
+	free_identifier_array(other_identifier_array);
+	free_token_tree(tree);
+	return ok ? 0 : -1;
+}
+
+int main() {
+	int status = 0;
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+		status |= render_case(&cases[i]);
+	}
+	return status != 0;
+}
@@ -0,0 +1,197 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include "arena.h"
+#include "docmark_lexer.h"
+#include "docmark_token.h"
+#include "generic_parser.h"
+#include "identifier_array.h"
+#include "output_sink.h"
+
+#define STRESS_DEPTH 1000000 // Levels of the synthetic trees
+#define DOCUMENT_LIST_DEPTH 1000 // Levels of lists in the lexed document, which costs quadratic space to nest
+#define SHALLOW_MAX_DEPTH 100 // A limit which every stress input exceeds
+#define STRESS_STACK_SIZE (256 * 1024) // Far too small for a pass which recurses once per level
+
+static void check(int condition, const char *description) {
+	printf("  %-60s %s\n", description, condition ? "ok" : "FAILED");
+	if (!condition) {
+		exit(1);
+	}
+}
+
+static long peak_memory_kilobytes() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+static size_t count_occurrences(const char *haystack, size_t length, const char *needle) {
+	size_t count = 0;
+	size_t needle_length = strlen(needle);
+	for (size_t i = 0; i + needle_length <= length; ++i) {
+		count += (memcmp(haystack + i, needle, needle_length) == 0);
+	}
+	return count;
+}
+
+/**
+ * @brief Builds a chain of tokens below the root, each the only child of the last, alternating between two types
+ *
+ * @return TokenId The top of the chain
+ */
+static TokenId build_chain(TokenTree *tree, TokenType even_type, TokenType odd_type, size_t depth, int raw) {
+	reset_token_tree(tree);
+	TokenId root = root_token(tree, "\0", 0); // Empty, so that only the chain is written
+	TokenId parent = root;
+	for (size_t i = 0; i < depth; ++i) {
+		parent = add_child(tree, (i % 2) ? odd_type : even_type, NULL, EMPTY_SPAN, EMPTY_SPAN, 0, parent);
+		if (raw) {
+			mark_raw(tree, parent);
+		}
+	}
+	if (raw) {
+		mark_raw(tree, root);
+	}
+	return tree->tokens.first_child[root];
+}
+
+static int parse_to_memory(TokenTree *tree, OutputSink **sink) {
+	IdentifierArray *heading_identifier_array = create_identifier_array();
+	IdentifierArray *other_identifier_array = create_identifier_array();
+	*sink = create_memory_sink();
+	order_token_tree(tree);
+	int result = parse_tree(tree, heading_identifier_array, other_identifier_array, *sink);
+	free_identifier_array(heading_identifier_array);
+	free_identifier_array(other_identifier_array);
+	return result;
+}
+
+static void stress_lexing(Arena *arena, TokenTree *tree) {
+	DocmarkLexContext *context = create_lex_context(arena, tree);
+
+	// Unrecognized tables are not lexed any further, so only the traversal itself is exercised
+	tree->max_depth = STRESS_DEPTH;
+	TokenId top = build_chain(tree, TWO_WAY_TABLE, TWO_WAY_TABLE, STRESS_DEPTH, 0);
+	check(lex_recursive(context, top) == 0, "lexes a 1M-level tree");
+	int all_raw = 1;
+	for (TokenId token = 0; token < tree->count; ++token) {
+		all_raw &= (token == 0) || is_raw(tree, token);
+	}
+	check(all_raw, "marks every level as lexed");
+
+	tree->max_depth = SHALLOW_MAX_DEPTH;
+	top = build_chain(tree, TWO_WAY_TABLE, TWO_WAY_TABLE, STRESS_DEPTH, 0);
+	check(lex_recursive(context, top) == -1, "refuses a tree deeper than the limit");
+
+	free_lex_context(context);
+}
+
+static void stress_parsing(TokenTree *tree) {
+	tree->max_depth = STRESS_DEPTH;
+	build_chain(tree, UNORDERED_LIST, LIST_ELEMENT, STRESS_DEPTH, 1);
+	order_token_tree(tree); // Touches every column once, so that only the parse itself is measured
+	long memory_before = peak_memory_kilobytes();
+	OutputSink *sink;
+	check(parse_to_memory(tree, &sink) == 0, "parses a 1M-level tree");
+	size_t expected_length = (STRESS_DEPTH / 2) * (sizeof("<ul>\n<li>\n") - 1 + sizeof("</li>\n</ul>\n") - 1);
+	check(sink->length == expected_length, "closes every level it opens");
+	long growth = peak_memory_kilobytes() - memory_before;
+	check(growth <= (long)(sink->length / 1024) * 2 + 4096, "needs no memory per level beyond its output");
+	free_sink(sink);
+
+	tree->max_depth = SHALLOW_MAX_DEPTH;
+	build_chain(tree, UNORDERED_LIST, LIST_ELEMENT, STRESS_DEPTH, 1);
+	check(parse_to_memory(tree, &sink) == -1, "refuses a tree deeper than the limit");
+	free_sink(sink);
+}
+
+/**
+ * @brief Builds lists nested `depth` levels deep, each level of which needs another continuation line
+ *
+ * @return char* The document, padded as a source buffer would be
+ */
+static char *build_nested_lists(size_t depth, size_t *length) {
+	size_t line_length = 2 * depth + 3;
+	char *document = (char *)malloc(line_length * (depth + 1) + 2);
+	if (document == NULL) {
+		fprintf(stderr, "ERROR: Memory allocation failed\n");
+		exit(1);
+	}
+
+	char *line = document;
+	for (size_t level = 0; level < depth; ++level) {
+		memcpy(line + 2 * level, "- ", 2);
+	}
+	memcpy(line + 2 * depth, "xy\n", 3);
+	for (size_t i = 0; i < depth; ++i) {
+		line += line_length;
+		memset(line, ' ', 2 * depth);
+		memcpy(line + 2 * depth, "yz\n", 3);
+	}
+	*length = line_length * (depth + 1);
+	document[*length] = '\0';
+	document[*length + 1] = '\0';
+	return document;
+}
+
+static void stress_document(Arena *arena, TokenTree *tree) {
+	size_t length;
+	char *document = build_nested_lists(DOCUMENT_LIST_DEPTH, &length);
+
+	reset_arena(arena);
+	reset_token_tree(tree);
+	tree->max_depth = STRESS_DEPTH;
+	DocmarkLexContext *context = create_lex_context(arena, tree);
+	check(lex_document(context, root_token(tree, document, length)) == 0, "lexes lists nested 1000 levels deep");
+	free_lex_context(context);
+
+	OutputSink *sink;
+	check(parse_to_memory(tree, &sink) == 0, "parses them");
+	check(count_occurrences(sink->buffer, sink->length, "<ul>") == DOCUMENT_LIST_DEPTH, "renders every level");
+	free_sink(sink);
+
+	reset_arena(arena);
+	reset_token_tree(tree);
+	tree->max_depth = SHALLOW_MAX_DEPTH;
+	context = create_lex_context(arena, tree);
+	check(lex_document(context, root_token(tree, document, length)) == -1, "refuses them beyond the limit");
+	free_lex_context(context);
+
+	free(document);
+}
+
+static void *run_stress(void *argument) {
+	(void)argument;
+	Arena *arena = create_arena(0, 0);
+	TokenTree *tree = create_token_tree();
+
+	stress_lexing(arena, tree);
+	stress_parsing(tree);
+	stress_document(arena, tree);
+
+	free_token_tree(tree);
+	free_arena(arena);
+	return NULL;
+}
+
+int main() {
+	// Every pass runs on a deliberately small stack, which recursing once per level would overflow
+	pthread_attr_t attributes;
+	pthread_attr_init(&attributes);
+	pthread_attr_setstacksize(&attributes, STRESS_STACK_SIZE);
+
+	pthread_t thread;
+	if (pthread_create(&thread, &attributes, run_stress, NULL) != 0) {
+		fprintf(stderr, "ERROR: Could not start the stress test\n");
+		return 1;
+	}
+	pthread_join(thread, NULL);
+	pthread_attr_destroy(&attributes);
+
+	printf("Peak memory: %ld KB\n", peak_memory_kilobytes());
+	return 0;
+}
@@ -0,0 +1,298 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "arena.h"
+#include "docmark_lexer.h"
+#include "docmark_token.h"
+#include "generic_parser.h"
+#include "identifier_array.h"
+#include "output_sink.h"
+
+#define PERF_REPETITIONS 7 // The median of which is taken, to filter out noise from the rest of the system
+#define PERF_DOUBLINGS 4 // Each case is timed at its base scale and this many doublings of it
+#define MAX_GROWTH_EXPONENT 1.2 // Of the time fitted against the scale; linear work grows as 1, n log n as about 1.05, quadratic as 2
+#define PERF_MAX_DEPTH (1u << 26) // Far beyond every case, which nest as deeply as they are large
+
+#if defined(DOCMARK_FLEX_LEXER)
+#define LEXER_NAME "flex"
+#else
+#define LEXER_NAME "handwritten"
+#endif
+
+typedef struct Document {
+	char *data;
+	size_t length;
+	size_t capacity;
+} Document;
+
+/**
+ * @brief An input which is lexed and parsed at several scales, each double the last
+ */
+typedef struct PerfCase {
+	const char *name;
+	size_t base_scale;
+	void (*build)(Document *document, size_t scale); // Writes the document at a scale
+	void (*add_tokens)(TokenTree *tree, size_t scale); // Adds tokens which no input can produce (NULL if none)
+	const char *flex_exception; // Why the flex scanner is not held to linear time (NULL if it is)
+} PerfCase;
+
+static void append(Document *document, const char *text, size_t length) {
+	if (document->length + length + 2 > document->capacity) { // Room for the sentinels
+		while (document->length + length + 2 > document->capacity) {
+			document->capacity = (document->capacity == 0) ? 4096 : document->capacity * 2;
+		}
+		document->data = (char *)realloc(document->data, document->capacity);
+		if (document->data == NULL) {
+			fprintf(stderr, "ERROR: Memory allocation failed\n");
+			exit(1);
+		}
+	}
+	memcpy(document->data + document->length, text, length);
+	document->length += length;
+}
+
+static void append_string(Document *document, const char *text) {
+	append(document, text, strlen(text));
+}
+
+static void append_repeated(Document *document, char character, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		append(document, &character, 1);
+	}
+}
+
+static void build_alternating_italics(Document *document, size_t scale) { // `*a` repeated along one line
+	for (size_t i = 0; i < scale / 2; ++i) {
+		append_string(document, "*a");
+	}
+	append_string(document, "\n");
+}
+
+static void build_unclosed_openers(Document *document, size_t scale) { // Every delimiter opened, and none closed
+	static const char pattern[] = "*a +a ~a -a =a ^a _a `a ";
+	for (size_t i = 0; i < scale / (sizeof(pattern) - 1); ++i) {
+		append_string(document, pattern);
+	}
+	append_string(document, "\n");
+}
+
+static void build_identical_headings(Document *document, size_t scale) {
+	for (size_t i = 0; i < scale; ++i) {
+		append_string(document, "# Notes\n\n");
+	}
+}
+
+static void build_single_heading(Document *document, size_t scale) {
+	(void)scale;
+	append_string(document, "# Notes\n");
+}
+
+static void add_footnotes(TokenTree *tree, size_t scale) { // All with the same name, under the same heading
+	static const char name[] = "1";
+	for (size_t i = 0; i < scale; ++i) {
+		TokenId footnote = add_child(tree, FOOTNOTE_REFERENCE, name, EMPTY_SPAN, (Span){0, 1}, 0, 0);
+		mark_raw(tree, footnote);
+	}
+}
+
+static void build_nested_lists(Document *document, size_t scale) { // One item per level, so the size grows with the square of the depth
+	size_t depth = 1;
+	while ((depth + 1) * (depth + 1) <= scale) {
+		++depth;
+	}
+	for (size_t level = 0; level < depth; ++level) {
+		append_repeated(document, ' ', 2 * level);
+		append_string(document, "- x\n");
+	}
+}
+
+static void build_nested_quote(Document *document, size_t scale) { // A single line nested once per character
+	append_repeated(document, '>', scale);
+	append_string(document, " x\n");
+}
+
+static void build_long_code_block(Document *document, size_t scale) {
+	append_string(document, "``c\n");
+	for (size_t i = 0; i < scale; ++i) {
+		append_string(document, "x\n");
+	}
+	append_string(document, "``\n");
+}
+
+// Named for their largest scale; the smallest is large enough to take tens of milliseconds, so that timer and
+// scheduling noise is small beside it
+static const PerfCase cases[] = {
+	{"4 MB lines of alternating *a", 256 * 1024, build_alternating_italics, NULL, NULL},
+	{"32 MB lines of unclosed delimiters", 2 * 1024 * 1024, build_unclosed_openers, NULL, NULL},
+	{"320k identical headings", 20000, build_identical_headings, NULL, NULL},
+	{"320k footnotes under one heading, added as tokens", 20000, build_single_heading, add_footnotes, NULL},
+	{"lists nested 8000 levels deep", 4 * 1024 * 1024, build_nested_lists, NULL, "it copies the rest of a list to lex each level"},
+	{"a blockquote nested 16M levels deep", 1024 * 1024, build_nested_quote, NULL, NULL},
+	{"a code block of 4M lines", 256 * 1024, build_long_code_block, NULL, NULL},
+};
+
+static double elapsed_seconds(const struct timespec *start, const struct timespec *end) {
+	return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int compare_seconds(const void *a, const void *b) {
+	double first = *(const double *)a;
+	double second = *(const double *)b;
+	return (first > second) - (first < second);
+}
+
+/**
+ * @brief Lexes and parses a case's document once, timing everything but building it
+ *
+ * @return double The time taken, in seconds (negative if the document failed to compile)
+ */
+static double time_document(
+	const PerfCase *perf_case,
+	const Document *document,
+	size_t scale,
+	Arena *arena,
+	TokenTree *tree,
+	IdentifierArray *heading_identifier_array,
+	IdentifierArray *other_identifier_array
+) {
+	reset_arena(arena);
+	reset_token_tree(tree);
+	reset_identifier_array(heading_identifier_array);
+	reset_identifier_array(other_identifier_array);
+	OutputSink *sink = create_memory_sink();
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	DocmarkLexContext *context = create_lex_context(arena, tree);
+	int result = lex_document(context, root_token(tree, document->data, document->length));
+	free_lex_context(context);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = elapsed_seconds(&start, &end);
+
+	if (perf_case->add_tokens) {
+		perf_case->add_tokens(tree, scale);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (result == 0) {
+		order_token_tree(tree);
+		result = parse_tree(tree, heading_identifier_array, other_identifier_array, sink);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	seconds += elapsed_seconds(&start, &end);
+	free_sink(sink);
+	return (result == 0) ? seconds : -1;
+}
+
+/**
+ * @brief Times a case at each scale, failing if its time grows faster than the scale by too much
+ *
+ * The repetitions take turns at every scale, so that noise which lasts a while slows each scale
+ * alike rather than one alone, and each scale is judged by its median time. Single doublings are
+ * still too noisy to judge on their own, so the case is judged by the exponent of a least-squares
+ * fit of the logarithm of its time against that of its scale.
+ *
+ * @return int (0 on success, -1 on failure)
+ */
+static int run_case(const PerfCase *perf_case, Arena *arena, TokenTree *tree) {
+	printf("  %s\n", perf_case->name);
+#if defined(DOCMARK_FLEX_LEXER)
+	if (perf_case->flex_exception) {
+		printf("    skipped, as the flex scanner is not linear here: %s\n", perf_case->flex_exception);
+		return 0;
+	}
+#endif
+	Document documents[PERF_DOUBLINGS + 1];
+	for (int doubling = 0; doubling <= PERF_DOUBLINGS; ++doubling) {
+		documents[doubling] = (Document){NULL, 0, 0};
+		perf_case->build(&documents[doubling], perf_case->base_scale << doubling);
+		documents[doubling].data[documents[doubling].length] = '\0';
+		documents[doubling].data[documents[doubling].length + 1] = '\0';
+	}
+
+	IdentifierArray *heading_identifier_array = create_identifier_array();
+	IdentifierArray *other_identifier_array = create_identifier_array();
+	double times[PERF_DOUBLINGS + 1][PERF_REPETITIONS];
+	int failed_doubling = -1;
+	for (int repetition = 0; repetition < PERF_REPETITIONS && failed_doubling < 0; ++repetition) {
+		for (int doubling = 0; doubling <= PERF_DOUBLINGS && failed_doubling < 0; ++doubling) {
+			times[doubling][repetition] = time_document(
+				perf_case,
+				&documents[doubling],
+				perf_case->base_scale << doubling,
+				arena,
+				tree,
+				heading_identifier_array,
+				other_identifier_array
+			);
+			if (times[doubling][repetition] < 0) {
+				failed_doubling = doubling;
+			}
+		}
+	}
+	free_identifier_array(heading_identifier_array);
+	free_identifier_array(other_identifier_array);
+	for (int doubling = 0; doubling <= PERF_DOUBLINGS; ++doubling) {
+		free(documents[doubling].data);
+	}
+	if (failed_doubling >= 0) {
+		printf("    %10zu  failed to compile\n", perf_case->base_scale << failed_doubling);
+		return -1;
+	}
+
+	double log_times[PERF_DOUBLINGS + 1];
+	double previous = 0;
+	for (int doubling = 0; doubling <= PERF_DOUBLINGS; ++doubling) {
+		qsort(times[doubling], PERF_REPETITIONS, sizeof(times[doubling][0]), compare_seconds);
+		double seconds = times[doubling][PERF_REPETITIONS / 2];
+
+		printf("    %10zu %10.3f ms", perf_case->base_scale << doubling, seconds * 1e3);
+		if (doubling > 0) {
+			printf("  x%.2f", seconds / previous);
+		}
+		printf("\n");
+		log_times[doubling] = log2(seconds);
+		previous = seconds;
+	}
+
+	// The scales are evenly spaced on a logarithmic scale (one doubling apart), so the fit needs only their mean
+	double mean_doubling = PERF_DOUBLINGS / 2.0;
+	double mean_log_time = 0;
+	for (int doubling = 0; doubling <= PERF_DOUBLINGS; ++doubling) {
+		mean_log_time += log_times[doubling] / (PERF_DOUBLINGS + 1);
+	}
+	double covariance = 0;
+	double variance = 0;
+	for (int doubling = 0; doubling <= PERF_DOUBLINGS; ++doubling) {
+		covariance += (doubling - mean_doubling) * (log_times[doubling] - mean_log_time);
+		variance += (doubling - mean_doubling) * (doubling - mean_doubling);
+	}
+	double exponent = covariance / variance;
+
+	int ok = exponent <= MAX_GROWTH_EXPONENT;
+	printf("    grows as scale^%.2f (at most ^%.2f) %s\n", exponent, MAX_GROWTH_EXPONENT, ok ? "ok" : "FAILED");
+	return ok ? 0 : -1;
+}
+
+int main() {
+	Arena *arena = create_arena(0, 0);
+	TokenTree *tree = create_token_tree();
+	tree->max_depth = PERF_MAX_DEPTH;
+
+	printf("%s lexer\n", LEXER_NAME);
+	int status = 0;
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+		status |= run_case(&cases[i], arena, tree);
+	}
+
+	free_token_tree(tree);
+	free_arena(arena);
+	if (status != 0) {
+		printf("Time grew faster than linearly with the input\n");
+		return 1;
+	}
+	return 0;
+}